@@ -0,0 +1,542 @@
+#ifndef BPLUSTREE_CPP
+#define BPLUSTREE_CPP
+
+#include <iostream>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+#include "KeySearch.cpp"
+using namespace std;
+
+// Ordered set with wide nodes: every node is NodeBytes long and starts on
+// a cache line, so a lookup touches a few lines per level instead of one
+// line per key compared. Keys live only in the leaves, which are chained
+// for range scans; inner nodes hold separators, where separator i is the
+// smallest key under child i + 1. Keys are unique.
+template <class T>
+class BPlusTree
+{
+    static const size_t NodeBytes = 256;
+    static const int LeafCapacity =
+        max<int>(4, (NodeBytes - sizeof(uint32_t) - sizeof(void *)) / sizeof(T));
+    static const int InnerCapacity =
+        max<int>(4, (NodeBytes - sizeof(uint32_t) - sizeof(void *)) / (sizeof(T) + sizeof(void *)));
+    static const int LeafMinimum = LeafCapacity / 2;
+    static const int InnerMinimum = InnerCapacity / 2;
+
+    struct alignas(64) Leaf
+    {
+        uint32_t count = 0;
+        T keys[LeafCapacity];
+        Leaf *next = nullptr;
+    };
+
+    struct alignas(64) Inner
+    {
+        uint32_t count = 0;
+        T keys[InnerCapacity];
+        void *children[InnerCapacity + 1];
+    };
+
+    // Leaves are the nodes at depth height, everything above is Inner.
+    void *root;
+    int height = 0;
+    size_t keyCount = 0;
+
+    const Leaf *findLeaf(const T &value) const
+    {
+        void *node = root;
+        for (int level = height; level > 0; level--)
+        {
+            const Inner *inner = static_cast<const Inner *>(node);
+            node = inner->children[countBelow<true>(inner->keys, inner->count, value)];
+        }
+        return static_cast<const Leaf *>(node);
+    }
+
+    // Adds value under node. When node overflows it keeps the lower half,
+    // the upper half goes to splitNode and its smallest key to splitKey.
+    bool insert(void *node, int level, T &value, T &splitKey, void *&splitNode)
+    {
+        splitNode = nullptr;
+        if (level == 0)
+        {
+            Leaf *leaf = static_cast<Leaf *>(node);
+            int position = countBelow<false>(leaf->keys, leaf->count, value);
+            if (position < (int)leaf->count && !(value < leaf->keys[position]))
+                return false;
+
+            if ((int)leaf->count < LeafCapacity)
+            {
+                move_backward(leaf->keys + position, leaf->keys + leaf->count, leaf->keys + leaf->count + 1);
+                leaf->keys[position] = std::move(value);
+                leaf->count++;
+                return true;
+            }
+
+            Leaf *right = new Leaf;
+            int leftCount = (LeafCapacity + 1) / 2;
+            if (position < leftCount)
+            {
+                move(leaf->keys + leftCount - 1, leaf->keys + LeafCapacity, right->keys);
+                move_backward(leaf->keys + position, leaf->keys + leftCount - 1, leaf->keys + leftCount);
+                leaf->keys[position] = std::move(value);
+            }
+            else
+            {
+                T *end = move(leaf->keys + leftCount, leaf->keys + position, right->keys);
+                *end = std::move(value);
+                move(leaf->keys + position, leaf->keys + LeafCapacity, end + 1);
+            }
+            leaf->count = leftCount;
+            right->count = LeafCapacity + 1 - leftCount;
+            right->next = leaf->next;
+            leaf->next = right;
+            splitKey = right->keys[0];
+            splitNode = right;
+            return true;
+        }
+
+        Inner *inner = static_cast<Inner *>(node);
+        int child = countBelow<true>(inner->keys, inner->count, value);
+        T childKey;
+        void *childSplit;
+        if (!insert(inner->children[child], level - 1, value, childKey, childSplit))
+            return false;
+        if (childSplit == nullptr)
+            return true;
+
+        if ((int)inner->count < InnerCapacity)
+        {
+            move_backward(inner->keys + child, inner->keys + inner->count, inner->keys + inner->count + 1);
+            copy_backward(inner->children + child + 1, inner->children + inner->count + 1, inner->children + inner->count + 2);
+            inner->keys[child] = std::move(childKey);
+            inner->children[child + 1] = childSplit;
+            inner->count++;
+            return true;
+        }
+
+        // Lay out all InnerCapacity + 1 separators in order, keep the
+        // lower half, push the middle one up and move the rest right.
+        T keys[InnerCapacity + 1];
+        void *children[InnerCapacity + 2];
+        move(inner->keys, inner->keys + child, keys);
+        keys[child] = std::move(childKey);
+        move(inner->keys + child, inner->keys + InnerCapacity, keys + child + 1);
+        copy(inner->children, inner->children + child + 1, children);
+        children[child + 1] = childSplit;
+        copy(inner->children + child + 1, inner->children + InnerCapacity + 1, children + child + 2);
+
+        Inner *right = new Inner;
+        int leftCount = InnerCapacity / 2;
+        move(keys, keys + leftCount, inner->keys);
+        copy(children, children + leftCount + 1, inner->children);
+        inner->count = leftCount;
+        splitKey = std::move(keys[leftCount]);
+        move(keys + leftCount + 1, keys + InnerCapacity + 1, right->keys);
+        copy(children + leftCount + 1, children + InnerCapacity + 2, right->children);
+        right->count = InnerCapacity - leftCount;
+        splitNode = right;
+        return true;
+    }
+
+    // Refills children[child] of parent, which fell below its minimum,
+    // by borrowing from a sibling or merging with one.
+    void fixLeaf(Inner *parent, int child)
+    {
+        Leaf *leaf = static_cast<Leaf *>(parent->children[child]);
+        Leaf *left = child > 0 ? static_cast<Leaf *>(parent->children[child - 1]) : nullptr;
+        Leaf *right = child < (int)parent->count ? static_cast<Leaf *>(parent->children[child + 1]) : nullptr;
+
+        if (left != nullptr && (int)left->count > LeafMinimum)
+        {
+            move_backward(leaf->keys, leaf->keys + leaf->count, leaf->keys + leaf->count + 1);
+            leaf->keys[0] = std::move(left->keys[--left->count]);
+            leaf->count++;
+            parent->keys[child - 1] = leaf->keys[0];
+        }
+        else if (right != nullptr && (int)right->count > LeafMinimum)
+        {
+            leaf->keys[leaf->count++] = std::move(right->keys[0]);
+            move(right->keys + 1, right->keys + right->count, right->keys);
+            right->count--;
+            parent->keys[child] = right->keys[0];
+        }
+        else
+        {
+            if (left == nullptr)
+            {
+                left = leaf;
+                leaf = right;
+                child++;
+            }
+            move(leaf->keys, leaf->keys + leaf->count, left->keys + left->count);
+            left->count += leaf->count;
+            left->next = leaf->next;
+            delete leaf;
+            removeSeparator(parent, child - 1);
+        }
+    }
+
+    void fixInner(Inner *parent, int child)
+    {
+        Inner *inner = static_cast<Inner *>(parent->children[child]);
+        Inner *left = child > 0 ? static_cast<Inner *>(parent->children[child - 1]) : nullptr;
+        Inner *right = child < (int)parent->count ? static_cast<Inner *>(parent->children[child + 1]) : nullptr;
+
+        if (left != nullptr && (int)left->count > InnerMinimum)
+        {
+            move_backward(inner->keys, inner->keys + inner->count, inner->keys + inner->count + 1);
+            copy_backward(inner->children, inner->children + inner->count + 1, inner->children + inner->count + 2);
+            inner->keys[0] = std::move(parent->keys[child - 1]);
+            inner->children[0] = left->children[left->count];
+            inner->count++;
+            parent->keys[child - 1] = std::move(left->keys[--left->count]);
+        }
+        else if (right != nullptr && (int)right->count > InnerMinimum)
+        {
+            inner->keys[inner->count] = std::move(parent->keys[child]);
+            inner->children[inner->count + 1] = right->children[0];
+            inner->count++;
+            parent->keys[child] = std::move(right->keys[0]);
+            move(right->keys + 1, right->keys + right->count, right->keys);
+            copy(right->children + 1, right->children + right->count + 1, right->children);
+            right->count--;
+        }
+        else
+        {
+            if (left == nullptr)
+            {
+                left = inner;
+                inner = right;
+                child++;
+            }
+            left->keys[left->count] = std::move(parent->keys[child - 1]);
+            move(inner->keys, inner->keys + inner->count, left->keys + left->count + 1);
+            copy(inner->children, inner->children + inner->count + 1, left->children + left->count + 1);
+            left->count += inner->count + 1;
+            delete inner;
+            removeSeparator(parent, child - 1);
+        }
+    }
+
+    // Drops separator index and the child to its right.
+    static void removeSeparator(Inner *parent, int index)
+    {
+        move(parent->keys + index + 1, parent->keys + parent->count, parent->keys + index);
+        copy(parent->children + index + 2, parent->children + parent->count + 1, parent->children + index + 1);
+        parent->count--;
+    }
+
+    bool remove(void *node, int level, const T &value)
+    {
+        if (level == 0)
+        {
+            Leaf *leaf = static_cast<Leaf *>(node);
+            int position = countBelow<false>(leaf->keys, leaf->count, value);
+            if (position == (int)leaf->count || value < leaf->keys[position])
+                return false;
+            move(leaf->keys + position + 1, leaf->keys + leaf->count, leaf->keys + position);
+            leaf->count--;
+            return true;
+        }
+
+        Inner *inner = static_cast<Inner *>(node);
+        int child = countBelow<true>(inner->keys, inner->count, value);
+        if (!remove(inner->children[child], level - 1, value))
+            return false;
+
+        if (level == 1)
+        {
+            if ((int)static_cast<Leaf *>(inner->children[child])->count < LeafMinimum)
+                fixLeaf(inner, child);
+        }
+        else if ((int)static_cast<Inner *>(inner->children[child])->count < InnerMinimum)
+            fixInner(inner, child);
+        return true;
+    }
+
+    void destroy(void *node, int level)
+    {
+        if (level == 0)
+        {
+            delete static_cast<Leaf *>(node);
+            return;
+        }
+        Inner *inner = static_cast<Inner *>(node);
+        for (int i = 0; i <= (int)inner->count; i++)
+            destroy(inner->children[i], level - 1);
+        delete inner;
+    }
+
+    // Checks node fill, key order inside each node and against the
+    // separators above it (lo <= key < hi), and that the leaves are chained
+    // in order. Adds the keys found to count.
+    bool validateNode(const void *node, int level, const T *lo, const T *hi, bool isRoot, const Leaf *&previous,
+                      size_t &count) const
+    {
+        if (level == 0)
+        {
+            const Leaf *leaf = static_cast<const Leaf *>(node);
+            if ((!isRoot && (int)leaf->count < LeafMinimum) || (previous != nullptr && previous->next != leaf))
+                return false;
+            previous = leaf;
+            count += leaf->count;
+            for (int i = 0; i < (int)leaf->count; i++)
+            {
+                if (i > 0 && !(leaf->keys[i - 1] < leaf->keys[i]))
+                    return false;
+                if ((lo != nullptr && leaf->keys[i] < *lo) || (hi != nullptr && !(leaf->keys[i] < *hi)))
+                    return false;
+            }
+            return true;
+        }
+
+        const Inner *inner = static_cast<const Inner *>(node);
+        int separators = (int)inner->count;
+        if (separators < (isRoot ? 1 : InnerMinimum))
+            return false;
+        for (int i = 1; i < separators; i++)
+            if (!(inner->keys[i - 1] < inner->keys[i]))
+                return false;
+        for (int i = 0; i <= separators; i++)
+            if (!validateNode(inner->children[i], level - 1, i == 0 ? lo : &inner->keys[i - 1],
+                              i == separators ? hi : &inner->keys[i], false, previous, count))
+                return false;
+        return true;
+    }
+
+    void print(void *node, int level, int depth) const
+    {
+        for (int i = 0; i < depth; i++)
+            cout << "  ";
+        if (level == 0)
+        {
+            Leaf *leaf = static_cast<Leaf *>(node);
+            for (int i = 0; i < (int)leaf->count; i++)
+                cout << leaf->keys[i] << " ";
+            cout << "\n";
+            return;
+        }
+        Inner *inner = static_cast<Inner *>(node);
+        cout << "|";
+        for (int i = 0; i < (int)inner->count; i++)
+            cout << " " << inner->keys[i];
+        cout << " |\n";
+        for (int i = 0; i <= (int)inner->count; i++)
+            print(inner->children[i], level - 1, depth + 1);
+    }
+
+public:
+    class iterator
+    {
+        friend class BPlusTree;
+        const Leaf *leaf = nullptr;
+        int index = 0;
+
+        // Moves past the end of a leaf onto the next one, skipping empty
+        // ones; only an empty root leaf can be empty.
+        iterator(const Leaf *leaf, int index) : leaf(leaf), index(index)
+        {
+            while (this->leaf != nullptr && this->index == (int)this->leaf->count)
+            {
+                this->leaf = this->leaf->next;
+                this->index = 0;
+            }
+        }
+
+    public:
+        typedef forward_iterator_tag iterator_category;
+        typedef T value_type;
+        typedef ptrdiff_t difference_type;
+        typedef const T *pointer;
+        typedef const T &reference;
+
+        iterator() {}
+
+        const T &operator*() const { return leaf->keys[index]; }
+        const T *operator->() const { return &leaf->keys[index]; }
+
+        iterator &operator++()
+        {
+            *this = iterator(leaf, index + 1);
+            return *this;
+        }
+        iterator operator++(int)
+        {
+            iterator old = *this;
+            ++*this;
+            return old;
+        }
+
+        bool operator==(const iterator &other) const { return leaf == other.leaf && index == other.index; }
+        bool operator!=(const iterator &other) const { return !(*this == other); }
+    };
+    typedef iterator const_iterator;
+
+    // Half-open [lo, hi) slice of the tree, usable in a range-for.
+    class Range
+    {
+        iterator first;
+        iterator last;
+
+    public:
+        Range(iterator first, iterator last) : first(first), last(last) {}
+        iterator begin() const { return first; }
+        iterator end() const { return last; }
+        bool empty() const { return first == last; }
+    };
+
+    BPlusTree() : root(new Leaf) {}
+    BPlusTree(const BPlusTree &) = delete;
+    BPlusTree &operator=(const BPlusTree &) = delete;
+
+    ~BPlusTree()
+    {
+        destroy(root, height);
+    }
+
+    void clear()
+    {
+        destroy(root, height);
+        root = new Leaf;
+        height = 0;
+        keyCount = 0;
+    }
+
+    size_t size() const
+    {
+        return keyCount;
+    }
+
+    bool empty() const
+    {
+        return keyCount == 0;
+    }
+
+    iterator begin() const
+    {
+        void *node = root;
+        for (int level = height; level > 0; level--)
+            node = static_cast<const Inner *>(node)->children[0];
+        return iterator(static_cast<const Leaf *>(node), 0);
+    }
+
+    iterator end() const
+    {
+        return iterator();
+    }
+
+    // First element that is not less than value.
+    iterator lower_bound(const T &value) const
+    {
+        const Leaf *leaf = findLeaf(value);
+        return iterator(leaf, countBelow<false>(leaf->keys, leaf->count, value));
+    }
+
+    // First element that is greater than value.
+    iterator upper_bound(const T &value) const
+    {
+        const Leaf *leaf = findLeaf(value);
+        return iterator(leaf, countBelow<true>(leaf->keys, leaf->count, value));
+    }
+
+    iterator find(const T &value) const
+    {
+        const Leaf *leaf = findLeaf(value);
+        int position = countBelow<false>(leaf->keys, leaf->count, value);
+        if (position < (int)leaf->count && !(value < leaf->keys[position]))
+            return iterator(leaf, position);
+        return end();
+    }
+
+    bool contains(const T &value) const
+    {
+        return find(value) != end();
+    }
+
+    Range range(const T &lo, const T &hi) const
+    {
+        if (hi < lo)
+            return Range(end(), end());
+        return Range(lower_bound(lo), lower_bound(hi));
+    }
+
+    // A key that is already in the tree is left alone.
+    void Insert(T value)
+    {
+        T splitKey;
+        void *splitNode;
+        if (!insert(root, height, value, splitKey, splitNode))
+            return;
+        keyCount++;
+        if (splitNode != nullptr)
+        {
+            Inner *newRoot = new Inner;
+            newRoot->count = 1;
+            newRoot->keys[0] = std::move(splitKey);
+            newRoot->children[0] = root;
+            newRoot->children[1] = splitNode;
+            root = newRoot;
+            height++;
+        }
+    }
+
+    void Delete(T value)
+    {
+        if (!remove(root, height, value))
+        {
+            cout << "not found\n";
+            return;
+        }
+        keyCount--;
+        if (height > 0 && static_cast<Inner *>(root)->count == 0)
+        {
+            Inner *oldRoot = static_cast<Inner *>(root);
+            root = oldRoot->children[0];
+            height--;
+            delete oldRoot;
+        }
+    }
+
+    // Checks the invariants above for the whole tree and the key count.
+    // For tests, O(n).
+    bool validate() const
+    {
+        const Leaf *previous = nullptr;
+        size_t count = 0;
+        return validateNode(root, height, nullptr, nullptr, true, previous, count) && previous->next == nullptr &&
+               count == keyCount;
+    }
+
+    void print() const
+    {
+        print(root, height, 0);
+    }
+};
+
+#ifndef NO_MAIN
+int main()
+{
+    BPlusTree<int> tree;
+    for (int i = 0; i < 200; i += 3)
+        tree.Insert(i);
+    tree.print();
+
+    tree.Delete(50);
+    for (int i = 0; i < 150; i += 3)
+        tree.Delete(i);
+    tree.print();
+
+    cout << "range [160, 190):";
+    for (int value : tree.range(160, 190))
+        cout << " " << value;
+    cout << endl;
+    return 0;
+}
+#endif
+
+#endif
@@ -0,0 +1,112 @@
+#define NO_MAIN
+#include <iostream>
+#include <cassert>
+#include <climits>
+#include <random>
+#include <set>
+#include <vector>
+#include "BPlusTree.cpp"
+
+// countBelow against lower_bound / upper_bound for every length around the
+// four key SSE2 blocks and a leaf, probing each key, its neighbours and
+// the extremes.
+void testCountBelow() {
+    for (int count = 0; count <= 70; count++) {
+        vector<int> keys;
+        for (int i = 0; i < count; i++) {
+            keys.push_back(i == 0 ? INT_MIN : i == count - 1 && count > 1 ? INT_MAX : i * 4 - 100);
+        }
+        vector<int> probes = {INT_MIN, INT_MAX, 0, -101};
+        for (int key : keys) {
+            if (key != INT_MIN) {
+                probes.push_back(key - 1);
+            }
+            probes.push_back(key);
+            if (key != INT_MAX) {
+                probes.push_back(key + 1);
+            }
+        }
+        for (int probe : probes) {
+            int below = int(lower_bound(keys.begin(), keys.end(), probe) - keys.begin());
+            int notAbove = int(upper_bound(keys.begin(), keys.end(), probe) - keys.begin());
+            assert(countBelow<false>(keys.data(), count, probe) == below);
+            assert(countBelow<true>(keys.data(), count, probe) == notAbove);
+        }
+    }
+}
+
+void testRandomInsertDelete() {
+    BPlusTree<int> tree;
+    set<int> reference;
+    mt19937 gen(1);
+    for (int i = 0; i < 100000; i++) {
+        int value = gen() % 20000;
+        if (gen() % 2 == 0) {
+            tree.Insert(value);
+            reference.insert(value);
+        }
+        else if (reference.erase(value)) {
+            tree.Delete(value);
+        }
+        if (i % 5000 == 0) {
+            assert(tree.validate());
+        }
+    }
+    assert(tree.validate());
+    assert(tree.size() == reference.size());
+    assert(equal(tree.begin(), tree.end(), reference.begin(), reference.end()));
+    for (int value = -1; value <= 20000; value++) {
+        assert(tree.contains(value) == (reference.count(value) != 0));
+        auto lower = reference.lower_bound(value);
+        assert(lower == reference.end() ? tree.lower_bound(value) == tree.end() : *tree.lower_bound(value) == *lower);
+    }
+}
+
+// Ascending inserts fill leaves and split them up to several levels;
+// deleting from the front, the back and every other key then borrows from
+// and merges with both neighbours until the tree collapses to one leaf.
+void testSplitBorrowMerge() {
+    BPlusTree<int> tree;
+    for (int i = 0; i < 50000; i++) {
+        tree.Insert(i);
+    }
+    assert(tree.validate());
+    for (int i = 0; i < 50000; i += 2) {
+        tree.Delete(i);
+    }
+    assert(tree.validate());
+    for (int i = 1; i < 10000; i += 2) {
+        tree.Delete(i);
+    }
+    assert(tree.validate());
+    for (int i = 49999; i >= 40000; i -= 2) {
+        tree.Delete(i);
+    }
+    assert(tree.validate());
+    assert(tree.size() == 15000);
+    int expected = 10001;
+    for (int value : tree) {
+        assert(value == expected);
+        expected += 2;
+    }
+    assert(expected == 40001);
+    for (int i = 10001; i < 40000; i += 2) {
+        tree.Delete(i);
+    }
+    assert(tree.validate());
+    assert(tree.empty() && tree.begin() == tree.end());
+
+    for (int i = 50000; i > 0; i--) {
+        tree.Insert(i);
+    }
+    assert(tree.validate());
+    assert(*tree.begin() == 1 && tree.size() == 50000);
+}
+
+int main() {
+    testCountBelow();
+    testRandomInsertDelete();
+    testSplitBorrowMerge();
+    std::cout << "All tests passed!" << std::endl;
+    return 0;
+}
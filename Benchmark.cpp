@@ -0,0 +1,642 @@
+#define NO_MAIN
+#include <iostream>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <random>
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include "HashTable.cpp"
+#include "RedBlackTree.cpp"
+#include "SkipList.cpp"
+#include "ConcurrentRedBlackTree.cpp"
+#include "ConcurrentSkipList.cpp"
+#include "LeftLeaningRedBlackTree.cpp"
+#include "BPlusTree.cpp"
+#include "BlockedSkipList.cpp"
+
+using namespace std;
+
+/**
+ * LatencyHistogram - HDR style histogram of latencies in nanoseconds
+ * @counts: one counter per (magnitude, sub bucket) pair
+ * @total: number of recorded values
+ * @maxValue: largest recorded value
+ *
+ * Values below 2^SubBucketBits are kept exactly, bigger values are
+ * grouped in 2^(SubBucketBits - 1) sub buckets per power of two, so every
+ * reported percentile is at most 1/128 (under 1%) above the recorded value.
+ */
+class LatencyHistogram {
+    private:
+    static const int SubBucketBits = 8;
+    static const int SubBucketCount = 1 << SubBucketBits;
+
+    vector<uint64_t> counts;
+    uint64_t total;
+    uint64_t maxValue;
+
+    static int indexOf(uint64_t value){
+        if(value < (uint64_t)SubBucketCount){
+            return (int)value;
+        }
+        int magnitude = 63 - __builtin_clzll(value);
+        int shift = magnitude - SubBucketBits + 1;
+        return shift * SubBucketCount + (int)(value >> shift);
+    }
+
+    static uint64_t valueAt(int index){
+        int shift = index / SubBucketCount;
+        uint64_t sub = index % SubBucketCount;
+        if(shift == 0){
+            return sub;
+        }
+        // highest value that lands in this bucket
+        return ((sub + 1) << shift) - 1;
+    }
+
+    public:
+    LatencyHistogram() : counts(64 * SubBucketCount, 0), total(0), maxValue(0) {}
+
+    /**
+     * record - add one latency sample
+     * @nanoseconds: measured latency
+     * return: void
+     */
+    void record(uint64_t nanoseconds){
+        counts[indexOf(nanoseconds)]++;
+        total++;
+        if(nanoseconds > maxValue){
+            maxValue = nanoseconds;
+        }
+    }
+
+    /**
+     * percentile - latency below which the given share of samples fall
+     * @percent: share in the range [0, 100]
+     * return: latency in nanoseconds, 0 if nothing is recorded
+     */
+    uint64_t percentile(double percent){
+        if(total == 0){
+            return 0;
+        }
+        uint64_t target = (uint64_t)(percent / 100.0 * total + 0.5);
+        if(target < 1){
+            target = 1;
+        }
+        uint64_t seen = 0;
+        for(int i = 0; i < (int)counts.size(); i++){
+            seen += counts[i];
+            if(seen >= target){
+                return min(valueAt(i), maxValue);
+            }
+        }
+        return maxValue;
+    }
+
+    uint64_t getMax(){
+        return maxValue;
+    }
+
+    uint64_t getCount(){
+        return total;
+    }
+};
+
+/**
+ * ResizeEvent - one operation that made the container grow
+ * @operation: index of the operation in the run
+ * @nanoseconds: latency of that operation
+ * @capacity: capacity after the resize
+ */
+struct ResizeEvent {
+    int operation;
+    uint64_t nanoseconds;
+    int capacity;
+};
+
+/**
+ * NoResize - resize probe for containers that never rebuild themselves
+ */
+template <class Container>
+struct NoResize {
+    static int count(Container &){ return 0; }
+    static int capacity(Container &){ return 0; }
+};
+
+/**
+ * TableResize - resize probe for the dynamic hash tables
+ */
+template <class Container>
+struct TableResize {
+    static int count(Container &table){ return table.getResizeCount(); }
+    static int capacity(Container &table){ return table.getCapacity(); }
+};
+
+void printLatencyReport(const string &name, LatencyHistogram &all, LatencyHistogram &steady,
+                        vector<ResizeEvent> &resizes, int showResizes){
+    cout << name << ": " << all.getCount() << " inserts" << endl;
+    cout << "  all      p50 " << all.percentile(50) << " ns, p99 " << all.percentile(99)
+         << " ns, p99.9 " << all.percentile(99.9) << " ns, max " << all.getMax() << " ns" << endl;
+    if(resizes.empty()){
+        cout << endl;
+        return;
+    }
+    cout << "  no resize p50 " << steady.percentile(50) << " ns, p99 " << steady.percentile(99)
+         << " ns, p99.9 " << steady.percentile(99.9) << " ns, max " << steady.getMax() << " ns" << endl;
+    cout << "  resizes: " << resizes.size() << endl;
+    int first = max(0, (int)resizes.size() - showResizes);
+    for(int i = first; i < (int)resizes.size(); i++){
+        cout << "    op " << resizes[i].operation << " -> capacity " << resizes[i].capacity
+             << ": " << resizes[i].nanoseconds << " ns" << endl;
+    }
+    cout << endl;
+}
+
+/**
+ * runLatency - time every insert separately and report the tail
+ * @name: label of the container
+ * @container: container under test
+ * @insert: callable that inserts one key into the container
+ * @keys: keys to insert, in order
+ * return: void
+ */
+template <class Container, class Probe, class Insert>
+void runLatency(const string &name, Container &container, Insert insert, const vector<int> &keys){
+    LatencyHistogram all;
+    LatencyHistogram steady;
+    vector<ResizeEvent> resizes;
+    for(int i = 0; i < (int)keys.size(); i++){
+        int resizesBefore = Probe::count(container);
+        auto start = chrono::steady_clock::now();
+        insert(container, keys[i]);
+        auto stop = chrono::steady_clock::now();
+        uint64_t elapsed = chrono::duration_cast<chrono::nanoseconds>(stop - start).count();
+        all.record(elapsed);
+        if(Probe::count(container) != resizesBefore){
+            resizes.push_back({i, elapsed, Probe::capacity(container)});
+        }
+        else {
+            steady.record(elapsed);
+        }
+    }
+    printLatencyReport(name, all, steady, resizes, 8);
+}
+
+/**
+ * latencyMode - insert heavy run over every dynamic container
+ * @operations: number of inserts per container
+ * return: void
+ */
+void latencyMode(int operations){
+    vector<int> keys(operations);
+    for(int i = 0; i < operations; i++){
+        keys[i] = i;
+    }
+    mt19937 gen(42);
+    shuffle(keys.begin(), keys.end(), gen);
+
+    {
+        HashTableChaining table(16);
+        runLatency<HashTableChaining, TableResize<HashTableChaining>>("HashTableChaining", table,
+            [](HashTableChaining &t, int key){ t.insertElement(key); }, keys);
+    }
+    {
+        HashTableOpenAddressing table(16);
+        runLatency<HashTableOpenAddressing, TableResize<HashTableOpenAddressing>>("HashTableOpenAddressing", table,
+            [](HashTableOpenAddressing &t, int key){ t.insertElement(key); }, keys);
+    }
+    {
+        HashTableDoubleHashing table(16);
+        runLatency<HashTableDoubleHashing, TableResize<HashTableDoubleHashing>>("HashTableDoubleHashing", table,
+            [](HashTableDoubleHashing &t, int key){ t.insertElement(key); }, keys);
+    }
+    {
+        HashTableString table(16);
+        runLatency<HashTableString, TableResize<HashTableString>>("HashTableString", table,
+            [](HashTableString &t, int key){ t.insertElement(to_string(key), key); }, keys);
+    }
+    {
+        RedBlackTree<int> tree;
+        runLatency<RedBlackTree<int>, NoResize<RedBlackTree<int>>>("RedBlackTree", tree,
+            [](RedBlackTree<int> &t, int key){ t.Insert(key); }, keys);
+    }
+    {
+        SkipList<int> list(HalfLevels(42));
+        runLatency<SkipList<int>, NoResize<SkipList<int>>>("SkipList", list,
+            [](SkipList<int> &l, int key){ l.insert(key); }, keys);
+    }
+}
+
+/**
+ * LockedRedBlackTree - RedBlackTree behind one mutex, the baseline for
+ * ConcurrentRedBlackTree
+ */
+class LockedRedBlackTree {
+    private:
+    RedBlackTree<int> tree;
+    mutex lock;
+
+    public:
+    void Insert(int value){
+        lock_guard<mutex> guard(lock);
+        tree.Insert(value);
+    }
+
+    void Delete(int value){
+        lock_guard<mutex> guard(lock);
+        tree.Delete(value);
+    }
+
+    bool contains(int value){
+        lock_guard<mutex> guard(lock);
+        return tree.contains(value);
+    }
+};
+
+/**
+ * runReadScaling - lookups per second with readers threads reading and
+ * one writer inserting and deleting the whole time
+ * @tree: tree filled with the even keys below keyCount
+ * @readers: number of reading threads
+ * @keyCount: size of the key space
+ * @milliseconds: length of the run
+ * return: lookups per second over all readers
+ */
+template <class Tree>
+double runReadScaling(Tree &tree, int readers, int keyCount, int milliseconds){
+    atomic<bool> running(true);
+    atomic<uint64_t> lookups(0);
+    // summed so the compiler cannot drop the lookups
+    atomic<uint64_t> hits(0);
+    vector<thread> threads;
+    for(int r = 0; r < readers; r++){
+        threads.push_back(thread([&tree, &running, &lookups, &hits, keyCount, r](){
+            mt19937 gen(r + 1);
+            uniform_int_distribution<int> key(0, keyCount - 1);
+            uint64_t done = 0;
+            uint64_t found = 0;
+            while(running.load(memory_order_relaxed)){
+                for(int i = 0; i < 256; i++){
+                    found += tree.contains(key(gen));
+                }
+                done += 256;
+            }
+            lookups += done;
+            hits += found;
+        }));
+    }
+    thread writer([&tree, &running, keyCount](){
+        mt19937 gen(0);
+        uniform_int_distribution<int> key(0, keyCount / 2 - 1);
+        while(running.load(memory_order_relaxed)){
+            int value = key(gen) * 2 + 1;
+            tree.Insert(value);
+            tree.Delete(value);
+        }
+    });
+
+    auto start = chrono::steady_clock::now();
+    this_thread::sleep_for(chrono::milliseconds(milliseconds));
+    running = false;
+    for(thread &t : threads){
+        t.join();
+    }
+    writer.join();
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    return lookups.load() / seconds;
+}
+
+/**
+ * readScalingMode - compare ConcurrentRedBlackTree with a mutex around
+ * RedBlackTree for 1, 2, 4, ... readers next to one writer
+ * @keyCount: size of the key space, half of it is in the tree
+ * return: void
+ */
+void readScalingMode(int keyCount){
+    unsigned hardware = max(2u, thread::hardware_concurrency());
+    ConcurrentRedBlackTree<int> concurrent;
+    LockedRedBlackTree locked;
+    for(int i = 0; i < keyCount; i += 2){
+        concurrent.Insert(i);
+        locked.Insert(i);
+    }
+
+    cout << "readers  locked (M lookups/s)  concurrent (M lookups/s)" << endl;
+    for(unsigned readers = 1; readers < hardware * 2; readers *= 2){
+        double lockedRate = runReadScaling(locked, readers, keyCount, 300);
+        double concurrentRate = runReadScaling(concurrent, readers, keyCount, 300);
+        cout << readers << "\t " << lockedRate / 1e6 << "\t\t\t" << concurrentRate / 1e6 << endl;
+    }
+}
+
+/**
+ * LockedSkipList - SkipList behind one mutex, the baseline for
+ * ConcurrentSkipList
+ */
+class LockedSkipList {
+    private:
+    SkipList<int> list;
+    mutex lock;
+
+    public:
+    bool insert(int value){
+        lock_guard<mutex> guard(lock);
+        return list.insert(value).second;
+    }
+
+    bool remove(int value){
+        lock_guard<mutex> guard(lock);
+        return list.remove(value);
+    }
+
+    bool exists(int value){
+        lock_guard<mutex> guard(lock);
+        return list.exists(value);
+    }
+};
+
+/**
+ * runMixed - operations per second with threads threads each running
+ * lookups, inserts and removes on random keys
+ * @set: set filled with half of the keys below keyCount
+ * @threads: number of threads
+ * @keyCount: size of the key space
+ * @lookupPercent: share of lookups, the rest is split evenly between
+ *                 inserts and removes so the size stays put
+ * @milliseconds: length of the run
+ * return: operations per second over all threads
+ */
+template <class Set>
+double runMixed(Set &set, int threads, int keyCount, int lookupPercent, int milliseconds){
+    atomic<bool> running(true);
+    atomic<uint64_t> operations(0);
+    // summed so the compiler cannot drop the lookups
+    atomic<uint64_t> hits(0);
+    vector<thread> workers;
+    for(int t = 0; t < threads; t++){
+        workers.push_back(thread([&set, &running, &operations, &hits, keyCount, lookupPercent, t](){
+            mt19937 gen(t + 1);
+            uniform_int_distribution<int> key(0, keyCount - 1);
+            uniform_int_distribution<int> percent(0, 99);
+            uint64_t done = 0;
+            uint64_t found = 0;
+            while(running.load(memory_order_relaxed)){
+                for(int i = 0; i < 256; i++){
+                    int roll = percent(gen);
+                    if(roll < lookupPercent){
+                        found += set.exists(key(gen));
+                    }
+                    else if((roll - lookupPercent) % 2 == 0){
+                        found += set.insert(key(gen));
+                    }
+                    else {
+                        found += set.remove(key(gen));
+                    }
+                }
+                done += 256;
+            }
+            operations += done;
+            hits += found;
+        }));
+    }
+
+    auto start = chrono::steady_clock::now();
+    this_thread::sleep_for(chrono::milliseconds(milliseconds));
+    running = false;
+    for(thread &t : workers){
+        t.join();
+    }
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    return operations.load() / seconds;
+}
+
+/**
+ * skipListScalingMode - compare ConcurrentSkipList with a mutex around
+ * SkipList for 1, 2, 4, ... 64 threads on a read heavy and a write heavy mix
+ * @keyCount: size of the key space, half of it is in the list
+ * return: void
+ */
+void skipListScalingMode(int keyCount){
+    const int mixes[] = {90, 50};
+    for(int lookupPercent : mixes){
+        ConcurrentSkipList<int> concurrent;
+        LockedSkipList locked;
+        for(int i = 0; i < keyCount; i += 2){
+            concurrent.insert(i);
+            locked.insert(i);
+        }
+
+        cout << lookupPercent << "% lookups, " << (100 - lookupPercent) << "% inserts and removes" << endl;
+        cout << "threads  locked (M ops/s)  concurrent (M ops/s)" << endl;
+        for(int threads = 1; threads <= 64; threads *= 2){
+            double lockedRate = runMixed(locked, threads, keyCount, lookupPercent, 300);
+            double concurrentRate = runMixed(concurrent, threads, keyCount, lookupPercent, 300);
+            cout << threads << "\t " << lockedRate / 1e6 << "\t\t   " << concurrentRate / 1e6 << endl;
+        }
+    }
+}
+
+/**
+ * runEngine - insert, look up and delete every key once and print the
+ * throughput of each phase
+ * @name: label of the tree
+ * @nodeBytes: size of one node of the tree
+ * @keys: keys in insert order
+ * @order: the same keys in lookup and delete order
+ * return: void
+ */
+template <class Tree>
+void runEngine(const string &name, size_t nodeBytes, const vector<int> &keys, const vector<int> &order){
+    Tree tree;
+    double n = keys.size();
+
+    auto start = chrono::steady_clock::now();
+    for(int key : keys){
+        tree.Insert(key);
+    }
+    double insertSeconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    start = chrono::steady_clock::now();
+    size_t found = 0;
+    for(int key : order){
+        found += tree.contains(key);
+    }
+    double lookupSeconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    start = chrono::steady_clock::now();
+    for(int key : order){
+        tree.Delete(key);
+    }
+    double deleteSeconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    cout << name << ": insert " << n / insertSeconds / 1e6 << " M/s, lookup " << n / lookupSeconds / 1e6
+         << " M/s, delete " << n / deleteSeconds / 1e6 << " M/s, " << nodeBytes << " bytes per node, "
+         << nodeBytes * keys.size() / (1024 * 1024) << " MiB of nodes" << (found == keys.size() ? "" : " (lookup mismatch)")
+         << endl;
+}
+
+/**
+ * enginesMode - bottom-up RedBlackTree against the parent-free
+ * LeftLeaningRedBlackTree on the same shuffled keys
+ * @operations: number of keys
+ * return: void
+ */
+void enginesMode(int operations){
+    vector<int> keys(operations);
+    for(int i = 0; i < operations; i++){
+        keys[i] = i;
+    }
+    mt19937 gen(42);
+    shuffle(keys.begin(), keys.end(), gen);
+    vector<int> order = keys;
+    shuffle(order.begin(), order.end(), gen);
+
+    runEngine<RedBlackTree<int>>("RedBlackTree", sizeof(Node<int>), keys, order);
+    runEngine<LeftLeaningRedBlackTree<int>>("LeftLeaningRedBlackTree", sizeof(LeftLeaningNode<int>), keys, order);
+}
+
+/**
+ * runOrdered - insert, look up, scan and delete every key once and print
+ * the throughput of each phase
+ * @name: label of the container
+ * @container: empty container under test
+ * @insert, @contains, @scan, @remove: callables doing one operation
+ * @keys: keys in insert order
+ * @order: the same keys in lookup and delete order
+ * return: void
+ */
+template <class Container, class Insert, class Contains, class Scan, class Remove>
+void runOrdered(const string &name, Container &container, Insert insert, Contains contains, Scan scan,
+                Remove remove, const vector<int> &keys, const vector<int> &order){
+    double n = keys.size();
+
+    auto start = chrono::steady_clock::now();
+    for(int key : keys){
+        insert(container, key);
+    }
+    double insertSeconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    start = chrono::steady_clock::now();
+    size_t found = 0;
+    for(int key : order){
+        found += contains(container, key);
+    }
+    double lookupSeconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    start = chrono::steady_clock::now();
+    long long sum = scan(container);
+    double scanSeconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    start = chrono::steady_clock::now();
+    for(int key : order){
+        remove(container, key);
+    }
+    double deleteSeconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    bool ok = found == keys.size() && sum == (long long)(n - 1) * (long long)n / 2;
+    cout << name << ": insert " << n / insertSeconds / 1e6 << " M/s, lookup " << n / lookupSeconds / 1e6
+         << " M/s, scan " << n / scanSeconds / 1e6 << " M/s, delete " << n / deleteSeconds / 1e6 << " M/s"
+         << (ok ? "" : " (mismatch)") << endl;
+}
+
+/**
+ * orderedMode - RedBlackTree, BPlusTree, SkipList and BlockedSkipList on the
+ * same keys
+ * @operations: number of keys
+ * return: void
+ */
+void orderedMode(int operations){
+    vector<int> keys(operations);
+    for(int i = 0; i < operations; i++){
+        keys[i] = i;
+    }
+    mt19937 gen(42);
+    shuffle(keys.begin(), keys.end(), gen);
+    vector<int> order = keys;
+    shuffle(order.begin(), order.end(), gen);
+
+    {
+        RedBlackTree<int> tree;
+        runOrdered("RedBlackTree", tree,
+            [](RedBlackTree<int> &t, int key){ t.Insert(key); },
+            [](RedBlackTree<int> &t, int key){ return t.contains(key); },
+            [](RedBlackTree<int> &t){ long long sum = 0; for(int value : t){ sum += value; } return sum; },
+            [](RedBlackTree<int> &t, int key){ t.Delete(key); }, keys, order);
+    }
+    {
+        BPlusTree<int> tree;
+        runOrdered("BPlusTree", tree,
+            [](BPlusTree<int> &t, int key){ t.Insert(key); },
+            [](BPlusTree<int> &t, int key){ return t.contains(key); },
+            [](BPlusTree<int> &t){ long long sum = 0; for(int value : t){ sum += value; } return sum; },
+            [](BPlusTree<int> &t, int key){ t.Delete(key); }, keys, order);
+    }
+    {
+        SkipList<int> list(HalfLevels(42));
+        runOrdered("SkipList", list,
+            [](SkipList<int> &l, int key){ l.insert(key); },
+            [](SkipList<int> &l, int key){ return l.exists(key); },
+            [](SkipList<int> &l){
+                long long sum = 0;
+                for(const SkipListNode<int> *node = l.getFirstNode(); node != nullptr; node = node->next()){
+                    sum += node->value;
+                }
+                return sum;
+            },
+            [](SkipList<int> &l, int key){ l.remove(key); }, keys, order);
+    }
+    {
+        BlockedSkipList<int> list{HalfLevels(42)};
+        runOrdered("BlockedSkipList", list,
+            [](BlockedSkipList<int> &l, int key){ l.insert(key); },
+            [](BlockedSkipList<int> &l, int key){ return l.exists(key); },
+            [](BlockedSkipList<int> &l){ long long sum = 0; for(int value : l){ sum += value; } return sum; },
+            [](BlockedSkipList<int> &l, int key){ l.remove(key); }, keys, order);
+    }
+}
+
+void usage(const char *program){
+    cout << "usage: " << program << " latency [operations]" << endl;
+    cout << "       " << program << " rbt-read-scaling [keys]" << endl;
+    cout << "       " << program << " skiplist-scaling [keys]" << endl;
+    cout << "       " << program << " rbt-engines [operations]" << endl;
+    cout << "       " << program << " ordered [operations]" << endl;
+}
+
+int main(int argc, char **argv){
+    if(argc < 2){
+        usage(argv[0]);
+        return 1;
+    }
+    string mode = argv[1];
+    if(mode == "latency"){
+        int operations = argc > 2 ? atoi(argv[2]) : 100000;
+        latencyMode(operations);
+    }
+    else if(mode == "rbt-read-scaling"){
+        int keys = argc > 2 ? atoi(argv[2]) : 1000000;
+        readScalingMode(keys);
+    }
+    else if(mode == "skiplist-scaling"){
+        int keys = argc > 2 ? atoi(argv[2]) : 1000000;
+        skipListScalingMode(keys);
+    }
+    else if(mode == "rbt-engines"){
+        int operations = argc > 2 ? atoi(argv[2]) : 1000000;
+        enginesMode(operations);
+    }
+    else if(mode == "ordered"){
+        int operations = argc > 2 ? atoi(argv[2]) : 1000000;
+        orderedMode(operations);
+    }
+    else {
+        usage(argv[0]);
+        return 1;
+    }
+    return 0;
+}
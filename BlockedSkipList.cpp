@@ -0,0 +1,558 @@
+#ifndef BLOCKEDSKIPLIST_CPP
+#define BLOCKEDSKIPLIST_CPP
+
+#include <iostream>
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "KeySearch.cpp"
+#include "NodeAllocator.cpp"
+#include "SkipListLevels.cpp"
+using namespace std;
+
+// Node of BlockedSkipList: count sorted keys, all greater than the keys of
+// the nodes before it. The forward pointers follow the node in the same
+// block, as in SkipListNode; the levels only ever look at keys[0].
+template <typename T, int Capacity>
+class BlockedSkipListNode
+{
+private:
+    int levelCount;
+    static size_t towerOffset()
+    {
+        const size_t pointerAlign = alignof(BlockedSkipListNode *);
+        return (sizeof(BlockedSkipListNode) + pointerAlign - 1) / pointerAlign * pointerAlign;
+    }
+    BlockedSkipListNode **forward()
+    {
+        return reinterpret_cast<BlockedSkipListNode **>(reinterpret_cast<char *>(this) + towerOffset());
+    }
+    BlockedSkipListNode *const *forward() const
+    {
+        return reinterpret_cast<BlockedSkipListNode *const *>(reinterpret_cast<const char *>(this) + towerOffset());
+    }
+    static size_t allocationSize(int levelCount)
+    {
+        return towerOffset() + levelCount * sizeof(BlockedSkipListNode *);
+    }
+    explicit BlockedSkipListNode(int levelCount) : levelCount(levelCount)
+    {
+        for (int level = 0; level < levelCount; level++)
+        {
+            forward()[level] = nullptr;
+        }
+    }
+
+public:
+    int count = 0;
+    T keys[Capacity];
+    BlockedSkipListNode(const BlockedSkipListNode &) = delete;
+    BlockedSkipListNode &operator=(const BlockedSkipListNode &) = delete;
+    template <typename Allocator>
+    static BlockedSkipListNode *create(Allocator &allocator, int levelCount)
+    {
+        return new (allocator.allocate(allocationSize(levelCount))) BlockedSkipListNode(levelCount);
+    }
+    template <typename Allocator>
+    static void destroy(Allocator &allocator, BlockedSkipListNode *node)
+    {
+        size_t bytes = allocationSize(node->levelCount);
+        node->~BlockedSkipListNode();
+        allocator.deallocate(node, bytes);
+    }
+    int getLevelCount() const
+    {
+        return levelCount;
+    }
+    // Levels are only range checked in debug builds.
+    BlockedSkipListNode *next(int level = 0) const
+    {
+#ifndef NDEBUG
+        if (level < 0 || level >= levelCount)
+        {
+            throw out_of_range("Level is out of valid range.");
+        }
+#endif
+        return forward()[level];
+    }
+    void setNext(BlockedSkipListNode *next, int level)
+    {
+#ifndef NDEBUG
+        if (level < 0 || level >= levelCount)
+        {
+            throw out_of_range("Level is out of valid range.");
+        }
+#endif
+        forward()[level] = next;
+    }
+};
+
+// Walks the keys in order, block by block.
+template <typename T, int Capacity>
+class BlockedSkipListIterator
+{
+    typedef BlockedSkipListNode<T, Capacity> NodeType;
+    const NodeType *node;
+    int index;
+
+public:
+    typedef forward_iterator_tag iterator_category;
+    typedef T value_type;
+    typedef ptrdiff_t difference_type;
+    typedef const T *pointer;
+    typedef const T &reference;
+
+    BlockedSkipListIterator(const NodeType *node = nullptr, int index = 0) : node(node), index(index) {}
+    reference operator*() const
+    {
+        return node->keys[index];
+    }
+    pointer operator->() const
+    {
+        return &node->keys[index];
+    }
+    BlockedSkipListIterator &operator++()
+    {
+        if (++index == node->count)
+        {
+            node = node->next();
+            index = 0;
+        }
+        return *this;
+    }
+    BlockedSkipListIterator operator++(int)
+    {
+        BlockedSkipListIterator previous = *this;
+        ++*this;
+        return previous;
+    }
+    bool operator==(const BlockedSkipListIterator &other) const
+    {
+        return node == other.node && index == other.index;
+    }
+    bool operator!=(const BlockedSkipListIterator &other) const
+    {
+        return !(*this == other);
+    }
+};
+
+// Skip list over blocks of keys. Every node holds up to Capacity sorted
+// keys (a cache line of them, 16 ints), so the levels index about
+// n / Capacity nodes instead of n and a search ends in a scan of one
+// block, which countBelow does four ints per SSE2 compare. A full node
+// splits in half on insert; on remove a node takes in its successor when
+// both fit in half a node, and empty nodes are unlinked. Keys are unique.
+template <typename T, class LevelGenerator = HalfLevels>
+class BlockedSkipList
+{
+public:
+    static const int Capacity = 64 / sizeof(T) < 4 ? 4 : 64 / sizeof(T);
+
+private:
+    typedef BlockedSkipListNode<T, Capacity> NodeType;
+    static const int MaxLevel = SkipListMaxLevel;
+    // How full bulkLoad packs its nodes, leaving room for inserts.
+    static const int BulkFill = Capacity * 3 / 4;
+    int count = 0;
+    int blockCount = 0;
+    int levelCount = 1;
+    SizeClassAllocator<alignof(NodeType)> pool;
+    NodeType *head;
+    LevelGenerator levels;
+
+    NodeType *createNode()
+    {
+        blockCount++;
+        return NodeType::create(pool, levels.next());
+    }
+    void destroyNode(NodeType *node)
+    {
+        blockCount--;
+        NodeType::destroy(pool, node);
+    }
+    // update[level] ends up as the last node on each level whose first key
+    // is less than value. Returns the node that holds value if it is in the
+    // list, the only node it could be added to otherwise; head when value
+    // is below every key.
+    NodeType *descend(const T &value, NodeType **update) const
+    {
+        NodeType *searchNode = head;
+        for (int level = levelCount - 1; level >= 0; level--)
+        {
+            NodeType *next = searchNode->next(level);
+            while (next && next->keys[0] < value)
+            {
+                searchNode = next;
+                next = searchNode->next(level);
+            }
+            update[level] = searchNode;
+        }
+        NodeType *next = searchNode->next();
+        return next && !(value < next->keys[0]) ? next : searchNode;
+    }
+    // Last node whose first key is not greater than value, or head.
+    NodeType *floorNode(const T &value) const
+    {
+        NodeType *searchNode = head;
+        for (int level = levelCount - 1; level >= 0; level--)
+        {
+            while (searchNode->next(level) && !(value < searchNode->next(level)->keys[0]))
+            {
+                searchNode = searchNode->next(level);
+            }
+        }
+        return searchNode;
+    }
+    // Links node in behind preds[level] on each of its levels.
+    void linkNode(NodeType *node, NodeType **preds)
+    {
+        for (; levelCount < node->getLevelCount(); levelCount++)
+        {
+            preds[levelCount] = head;
+        }
+        for (int level = 0; level < node->getLevelCount(); level++)
+        {
+            node->setNext(preds[level]->next(level), level);
+            preds[level]->setNext(node, level);
+        }
+    }
+    void unlinkNode(NodeType *node, NodeType **preds)
+    {
+        for (int level = 0; level < node->getLevelCount(); level++)
+        {
+            preds[level]->setNext(node->next(level), level);
+        }
+        while (levelCount > 1 && !head->next(levelCount - 1))
+        {
+            levelCount--;
+        }
+    }
+    // Moves the keys of node's successor into node and drops the successor.
+    void absorbNext(NodeType *node)
+    {
+        NodeType *next = node->next();
+        NodeType *update[MaxLevel];
+        descend(next->keys[0], update);
+        move(next->keys, next->keys + next->count, node->keys + node->count);
+        node->count += next->count;
+        unlinkNode(next, update);
+        destroyNode(next);
+    }
+    void destroyNodes()
+    {
+        NodeType *node = head->next();
+        while (node)
+        {
+            NodeType *temp = node->next();
+            destroyNode(node);
+            node = temp;
+        }
+        for (int level = 0; level < levelCount; level++)
+        {
+            head->setNext(nullptr, level);
+        }
+        levelCount = 1;
+        count = 0;
+    }
+
+public:
+    typedef BlockedSkipListIterator<T, Capacity> iterator;
+
+    BlockedSkipList(const BlockedSkipList &) = delete;
+    BlockedSkipList &operator=(const BlockedSkipList &) = delete;
+    explicit BlockedSkipList(const LevelGenerator &levels = LevelGenerator())
+        : head(NodeType::create(pool, MaxLevel)), levels(levels)
+    {
+    }
+    template <typename Container>
+    BlockedSkipList(const Container &array, const LevelGenerator &levels = LevelGenerator())
+        : head(NodeType::create(pool, MaxLevel)), levels(levels)
+    {
+        bulkLoad(std::begin(array), std::end(array));
+    }
+    ~BlockedSkipList()
+    {
+        destroyNodes();
+        NodeType::destroy(pool, head);
+    }
+
+    int getCount() const
+    {
+        return count;
+    }
+    int getBlockCount() const
+    {
+        return blockCount;
+    }
+    int getLevelCount() const
+    {
+        return levelCount;
+    }
+    iterator begin() const
+    {
+        return iterator(head->next());
+    }
+    iterator end() const
+    {
+        return iterator();
+    }
+    // First key not less than value.
+    iterator lower_bound(const T &value) const
+    {
+        const NodeType *node = floorNode(value);
+        if (node == head)
+        {
+            return begin();
+        }
+        int position = countBelow<false>(node->keys, node->count, value);
+        return position < node->count ? iterator(node, position) : iterator(node->next());
+    }
+    iterator find(const T &value) const
+    {
+        iterator it = lower_bound(value);
+        return it != end() && !(value < *it) ? it : end();
+    }
+    bool exists(const T &value) const
+    {
+        return find(value) != end();
+    }
+
+    // Adds value unless it is present; returns the key and whether it was
+    // inserted.
+    pair<iterator, bool> insert(const T &value)
+    {
+        NodeType *update[MaxLevel];
+        NodeType *node = descend(value, update);
+        if (node == head)
+        {
+            node = head->next();
+            if (!node)
+            {
+                node = createNode();
+                linkNode(node, update);
+            }
+        }
+        else
+        {
+            int position = countBelow<false>(node->keys, node->count, value);
+            if (position < node->count && !(value < node->keys[position]))
+            {
+                return make_pair(iterator(node, position), false);
+            }
+        }
+
+        if (node->count == Capacity)
+        {
+            const int half = Capacity / 2;
+            NodeType *upper = createNode();
+            move(node->keys + half, node->keys + Capacity, upper->keys);
+            upper->count = Capacity - half;
+            node->count = half;
+            // Nothing lies between node and upper, so node is upper's
+            // predecessor on node's levels and update[] above them.
+            for (int level = 0; level < node->getLevelCount(); level++)
+            {
+                update[level] = node;
+            }
+            linkNode(upper, update);
+            if (!(value < upper->keys[0]))
+            {
+                node = upper;
+            }
+        }
+
+        int position = countBelow<false>(node->keys, node->count, value);
+        move_backward(node->keys + position, node->keys + node->count, node->keys + node->count + 1);
+        node->keys[position] = value;
+        node->count++;
+        count++;
+        return make_pair(iterator(node, position), true);
+    }
+    // false when value is not present.
+    bool remove(const T &value)
+    {
+        NodeType *update[MaxLevel];
+        NodeType *node = descend(value, update);
+        if (node == head)
+        {
+            return false;
+        }
+        int position = countBelow<false>(node->keys, node->count, value);
+        if (position == node->count || value < node->keys[position])
+        {
+            return false;
+        }
+        move(node->keys + position + 1, node->keys + node->count, node->keys + position);
+        node->count--;
+        count--;
+        if (node->count == 0)
+        {
+            // Its only key was value, so update[] holds its predecessors.
+            unlinkNode(node, update);
+            destroyNode(node);
+        }
+        else if (node->next() && node->count + node->next()->count <= Capacity / 2)
+        {
+            absorbNext(node);
+        }
+        return true;
+    }
+    void clear()
+    {
+        destroyNodes();
+    }
+    // Replaces the contents with [first, last), packing BulkFill keys per
+    // node and linking every level in one left to right pass. Unsorted
+    // input is sorted into a copy first, and so is single pass input,
+    // which the sortedness check would consume.
+    template <typename Iterator>
+    void bulkLoad(Iterator first, Iterator last)
+    {
+        typedef typename iterator_traits<Iterator>::iterator_category Category;
+        if constexpr (!is_base_of<forward_iterator_tag, Category>::value)
+        {
+            vector<T> staged(first, last);
+            bulkLoad(staged.begin(), staged.end());
+        }
+        else if (!is_sorted(first, last))
+        {
+            vector<T> sorted(first, last);
+            sort(sorted.begin(), sorted.end());
+            bulkLoad(sorted.begin(), sorted.end());
+        }
+        else
+        {
+            clear();
+            vector<NodeType *> tails(MaxLevel, head);
+            NodeType *node = nullptr;
+            for (; first != last; ++first)
+            {
+                if (node && !(node->keys[node->count - 1] < *first))
+                {
+                    continue;
+                }
+                if (!node || node->count == BulkFill)
+                {
+                    node = createNode();
+                    for (int level = 0; level < node->getLevelCount(); level++)
+                    {
+                        tails[level]->setNext(node, level);
+                        tails[level] = node;
+                    }
+                    if (node->getLevelCount() > levelCount)
+                    {
+                        levelCount = node->getLevelCount();
+                    }
+                }
+                node->keys[node->count++] = *first;
+                count++;
+            }
+        }
+    }
+    // Every node holds 1 to Capacity keys, keys increase across nodes,
+    // each level links a subsequence of the level below it, no level at or
+    // above levelCount is linked and the counts add up.
+    bool validate() const
+    {
+        int keys = 0;
+        int blocks = 0;
+        const T *previous = nullptr;
+        for (const NodeType *node = head->next(); node; node = node->next())
+        {
+            if (node->count < 1 || node->count > Capacity)
+            {
+                return false;
+            }
+            for (int i = 0; i < node->count; i++)
+            {
+                if (previous && !(*previous < node->keys[i]))
+                {
+                    return false;
+                }
+                previous = &node->keys[i];
+            }
+            keys += node->count;
+            blocks++;
+        }
+        if (keys != count || blocks != blockCount)
+        {
+            return false;
+        }
+        for (int level = 1; level < levelCount; level++)
+        {
+            const NodeType *below = head;
+            for (const NodeType *node = head->next(level); node; node = node->next(level))
+            {
+                while (below && below != node)
+                {
+                    below = below->next(level - 1);
+                }
+                if (!below)
+                {
+                    return false;
+                }
+            }
+        }
+        for (int level = levelCount; level < MaxLevel; level++)
+        {
+            if (head->next(level))
+            {
+                return false;
+            }
+        }
+        return levelCount == 1 || head->next(levelCount - 1);
+    }
+    void printItems() const
+    {
+        cout << "List: ";
+        if (count == 0)
+        {
+            cout << "empty" << endl;
+            return;
+        }
+        for (const NodeType *node = head->next(); node; node = node->next())
+        {
+            cout << "[";
+            for (int i = 0; i < node->count; i++)
+            {
+                cout << node->keys[i] << (i + 1 < node->count ? " " : "");
+            }
+            cout << "]" << (node->next() ? " " : "");
+        }
+        cout << endl;
+    }
+};
+
+#ifndef NO_MAIN
+int main()
+{
+    BlockedSkipList<int> list{HalfLevels(7)};
+    for (int i = 0; i < 100; i++)
+    {
+        list.insert(i * 37 % 100);
+    }
+    for (int i = 0; i < 100; i += 3)
+    {
+        list.remove(i);
+    }
+    list.printItems();
+    cout << list.getCount() << " keys in " << list.getBlockCount() << " blocks, " << list.getLevelCount() << " levels" << endl;
+    cout << "exists 40: " << list.exists(40) << ", exists 42: " << list.exists(42)
+         << ", first key >= 50: " << *list.lower_bound(50) << endl;
+
+    BlockedSkipList<int> loaded(vector<int>{9, 3, 7, 1, 5, 3});
+    for (int value : loaded)
+    {
+        cout << value << " ";
+    }
+    cout << endl;
+    return 0;
+}
+#endif
+
+#endif
@@ -0,0 +1,201 @@
+#define NO_MAIN
+#include <iostream>
+#include <cassert>
+#include <climits>
+#include <iterator>
+#include <random>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "BlockedSkipList.cpp"
+
+template <class T>
+void checkList(BlockedSkipList<T> &list, const set<T> &reference) {
+    assert(list.validate());
+    assert(list.getCount() == (int)reference.size());
+    assert(equal(list.begin(), list.end(), reference.begin(), reference.end()));
+}
+
+// exists and lower_bound agree with std::set for every value in
+// [low, high], so each key at the edge of a block and the gaps next to it
+// are all looked up.
+void checkLookups(BlockedSkipList<int> &list, const set<int> &reference, int low, int high) {
+    for (long long value = low; value <= high; value++) {
+        int key = (int)value;
+        assert(list.exists(key) == (reference.count(key) == 1));
+        auto lower = list.lower_bound(key);
+        auto expected = reference.lower_bound(key);
+        assert((lower == list.end()) == (expected == reference.end()));
+        assert(lower == list.end() || *lower == *expected);
+    }
+}
+
+// A growing phase splits full blocks, a shrinking phase empties blocks and
+// folds neighbours together, and a mixed phase does both.
+void testRandomInsertRemove() {
+    BlockedSkipList<int> list{HalfLevels(1)};
+    set<int> reference;
+    mt19937 gen(1);
+    const int keys = 20000;
+    const int insertPercent[] = {90, 10, 50};
+    int peakBlocks = 0;
+    for (int phase = 0; phase < 3; phase++) {
+        for (int i = 0; i < 100000; i++) {
+            int value = gen() % keys;
+            int op = gen() % 100;
+            if (op < insertPercent[phase]) {
+                auto inserted = list.insert(value);
+                assert(inserted.second == reference.insert(value).second);
+                assert(*inserted.first == value);
+            }
+            else {
+                assert(list.remove(value) == (reference.erase(value) == 1));
+            }
+            assert(list.exists(value) == (reference.count(value) == 1));
+            if (i % 10000 == 0) {
+                checkList(list, reference);
+            }
+            peakBlocks = max(peakBlocks, list.getBlockCount());
+        }
+        checkList(list, reference);
+        checkLookups(list, reference, -1, keys);
+        if (phase == 0) {
+            assert(list.getBlockCount() > keys / BlockedSkipList<int>::Capacity);
+        }
+        if (phase == 1) {
+            assert(list.getBlockCount() < peakBlocks / 4);
+        }
+    }
+
+    for (int value : set<int>(reference)) {
+        assert(list.remove(value));
+        reference.erase(value);
+    }
+    checkList(list, reference);
+    assert(list.getBlockCount() == 0 && list.getLevelCount() == 1);
+}
+
+// Keys at the ends of the int range and at both ends of every block. Odd
+// keys land exactly between two blocks and split them, then the even keys
+// around them go away again.
+void testBoundaries() {
+    const int n = 2000;
+    BlockedSkipList<int> list{HalfLevels(2)};
+    set<int> reference;
+    vector<int> evens;
+    for (int i = 0; i < n; i++) {
+        evens.push_back(2 * i);
+    }
+    list.bulkLoad(evens.begin(), evens.end());
+    reference.insert(evens.begin(), evens.end());
+    checkList(list, reference);
+    checkLookups(list, reference, -3, 2 * n + 3);
+
+    vector<int> odds;
+    for (int i = 0; i < n; i++) {
+        odds.push_back(2 * i + 1);
+    }
+    shuffle(odds.begin(), odds.end(), mt19937(2));
+    for (int value : odds) {
+        assert(list.insert(value).second);
+        reference.insert(value);
+    }
+    checkList(list, reference);
+    checkLookups(list, reference, -3, 2 * n + 3);
+
+    for (int value : evens) {
+        assert(list.remove(value));
+        reference.erase(value);
+    }
+    checkList(list, reference);
+    checkLookups(list, reference, -3, 2 * n + 3);
+
+    for (int value : {INT_MIN, INT_MIN + 1, INT_MAX - 1, INT_MAX}) {
+        assert(!list.exists(value));
+        assert(list.insert(value).second);
+        assert(!list.insert(value).second);
+        reference.insert(value);
+    }
+    checkList(list, reference);
+    checkLookups(list, reference, INT_MIN, INT_MIN + 3);
+    checkLookups(list, reference, INT_MAX - 3, INT_MAX);
+    checkLookups(list, reference, -3, 2 * n + 3);
+    assert(*list.begin() == INT_MIN && list.find(INT_MAX) != list.end());
+    assert(list.lower_bound(INT_MAX - 2) != list.end() && *list.lower_bound(INT_MAX - 2) == INT_MAX - 1);
+}
+
+// Strings get four keys per block, so splits and merges come often.
+void testStrings() {
+    BlockedSkipList<string> list{HalfLevels(3)};
+    set<string> reference;
+    mt19937 gen(3);
+    for (int i = 0; i < 20000; i++) {
+        string value = "key-" + to_string(gen() % 500) + string(gen() % 30, 'x');
+        if (gen() % 2 == 0) {
+            assert(list.insert(value).second == reference.insert(value).second);
+        }
+        else {
+            assert(list.remove(value) == (reference.erase(value) == 1));
+        }
+        assert(list.exists(value) == (reference.count(value) == 1));
+    }
+    checkList(list, reference);
+}
+
+void testBulkLoad() {
+    mt19937 gen(4);
+    vector<int> values;
+    for (int i = 0; i < 5000; i++) {
+        values.push_back(gen() % 3000);
+    }
+    set<int> reference(values.begin(), values.end());
+
+    BlockedSkipList<int> list{HalfLevels(4)};
+    list.insert(-5);
+    list.bulkLoad(values.begin(), values.end());
+    checkList(list, reference);
+    checkLookups(list, reference, -2, 3002);
+
+    // Single pass input is read once, sorted or not.
+    stringstream ascending;
+    stringstream descending;
+    for (int value : reference) {
+        ascending << value << ' ';
+    }
+    for (auto it = reference.rbegin(); it != reference.rend(); ++it) {
+        descending << *it << ' ';
+    }
+    list.bulkLoad(istream_iterator<int>(ascending), istream_iterator<int>());
+    checkList(list, reference);
+    list.bulkLoad(istream_iterator<int>(descending), istream_iterator<int>());
+    checkList(list, reference);
+
+    // Loaded blocks keep room for inserts and still merge on removes.
+    set<int> copy = reference;
+    for (int i = 0; i < 5000; i++) {
+        int value = gen() % 3000;
+        if (gen() % 2 == 0) {
+            assert(list.insert(value).second == copy.insert(value).second);
+        }
+        else {
+            assert(list.remove(value) == (copy.erase(value) == 1));
+        }
+    }
+    checkList(list, copy);
+
+    list.bulkLoad(values.begin(), values.begin());
+    checkList(list, set<int>());
+
+    BlockedSkipList<int> built(values, HalfLevels(5));
+    checkList(built, reference);
+}
+
+int main() {
+    testRandomInsertRemove();
+    testBoundaries();
+    testStrings();
+    testBulkLoad();
+    std::cout << "All tests passed!" << std::endl;
+    return 0;
+}
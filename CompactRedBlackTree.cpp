@@ -0,0 +1,513 @@
+#ifndef COMPACTREDBLACKTREE_CPP
+#define COMPACTREDBLACKTREE_CPP
+
+#include <iostream>
+#include <cstdint>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+#include "Snapshot.cpp"
+using namespace std;
+
+// Links are 32 bit indices into the node array, the parent link also
+// carries the color in its low bit. Index 0 is the black nil sentinel.
+template <class T>
+struct CompactNode
+{
+    T value;
+    uint32_t left;
+    uint32_t right;
+    uint32_t parentAndColor;
+};
+
+template <class T>
+class CompactRedBlackTree
+{
+    static const uint32_t nil = 0;
+    // Slots the node array may hold, so every index fits the 31 bits the
+    // parent link leaves next to the color.
+    static const size_t MaxSlots = UINT32_MAX >> 1;
+
+    vector<CompactNode<T>> nodes;
+    uint32_t root = nil;
+    uint32_t freeList = nil;
+    size_t count = 0;
+
+    uint32_t left(uint32_t node) const { return nodes[node].left; }
+    uint32_t right(uint32_t node) const { return nodes[node].right; }
+    uint32_t parent(uint32_t node) const { return nodes[node].parentAndColor >> 1; }
+    bool isRed(uint32_t node) const { return nodes[node].parentAndColor & 1; }
+
+    void setLeft(uint32_t node, uint32_t child) { nodes[node].left = child; }
+    void setRight(uint32_t node, uint32_t child) { nodes[node].right = child; }
+    void setParent(uint32_t node, uint32_t parent)
+    {
+        nodes[node].parentAndColor = (parent << 1) | (nodes[node].parentAndColor & 1);
+    }
+    void setRed(uint32_t node, bool red)
+    {
+        nodes[node].parentAndColor = (nodes[node].parentAndColor & ~1u) | (red ? 1u : 0u);
+    }
+
+    uint32_t createNode(T value)
+    {
+        uint32_t node;
+        if (freeList != nil)
+        {
+            node = freeList;
+            freeList = nodes[node].left;
+            nodes[node].value = std::move(value);
+        }
+        else
+        {
+            if (nodes.size() >= MaxSlots)
+                throw length_error("CompactRedBlackTree is full.");
+            node = (uint32_t)nodes.size();
+            nodes.push_back(CompactNode<T>{std::move(value), nil, nil, 0});
+        }
+        nodes[node].left = nil;
+        nodes[node].right = nil;
+        nodes[node].parentAndColor = 1;
+        return node;
+    }
+
+    // Freed slots are chained through their left link.
+    void destroyNode(uint32_t node)
+    {
+        nodes[node].left = freeList;
+        nodes[node].parentAndColor = 0;
+        freeList = node;
+    }
+
+    uint32_t getMinimum(uint32_t node) const
+    {
+        while (left(node) != nil)
+            node = left(node);
+        return node;
+    }
+
+    uint32_t findNode(const T &value) const
+    {
+        uint32_t current = root;
+        while (current != nil)
+        {
+            if (value < nodes[current].value)
+                current = left(current);
+            else if (nodes[current].value < value)
+                current = right(current);
+            else
+                return current;
+        }
+        return nil;
+    }
+
+    void leftRotate(uint32_t node)
+    {
+        uint32_t newParent = right(node);
+        setRight(node, left(newParent));
+
+        if (left(newParent) != nil)
+            setParent(left(newParent), node);
+
+        setParent(newParent, parent(node));
+
+        if (parent(node) == nil)
+            root = newParent;
+        else if (node == left(parent(node)))
+            setLeft(parent(node), newParent);
+        else
+            setRight(parent(node), newParent);
+
+        setLeft(newParent, node);
+        setParent(node, newParent);
+    }
+
+    void rightRotate(uint32_t node)
+    {
+        uint32_t newParent = left(node);
+        setLeft(node, right(newParent));
+
+        if (right(newParent) != nil)
+            setParent(right(newParent), node);
+
+        setParent(newParent, parent(node));
+
+        if (parent(node) == nil)
+            root = newParent;
+        else if (node == left(parent(node)))
+            setLeft(parent(node), newParent);
+        else
+            setRight(parent(node), newParent);
+
+        setRight(newParent, node);
+        setParent(node, newParent);
+    }
+
+    void FixInsert(uint32_t node)
+    {
+        while (node != root && isRed(parent(node)))
+        {
+            uint32_t grandParent = parent(parent(node));
+            if (parent(node) == left(grandParent))
+            {
+                uint32_t uncle = right(grandParent);
+                if (isRed(uncle))
+                {
+                    setRed(parent(node), false);
+                    setRed(uncle, false);
+                    setRed(grandParent, true);
+                    node = grandParent;
+                }
+                else
+                {
+                    if (node == right(parent(node)))
+                    {
+                        node = parent(node);
+                        leftRotate(node);
+                    }
+                    setRed(parent(node), false);
+                    setRed(parent(parent(node)), true);
+                    rightRotate(parent(parent(node)));
+                }
+            }
+            else
+            {
+                uint32_t uncle = left(grandParent);
+                if (isRed(uncle))
+                {
+                    setRed(parent(node), false);
+                    setRed(uncle, false);
+                    setRed(grandParent, true);
+                    node = grandParent;
+                }
+                else
+                {
+                    if (node == left(parent(node)))
+                    {
+                        node = parent(node);
+                        rightRotate(node);
+                    }
+                    setRed(parent(node), false);
+                    setRed(parent(parent(node)), true);
+                    leftRotate(parent(parent(node)));
+                }
+            }
+        }
+        setRed(root, false);
+    }
+
+    // The nil sentinel may take a parent here, FixDelete walks up from it.
+    void replaceNode(uint32_t oldNode, uint32_t newNode)
+    {
+        if (parent(oldNode) == nil)
+            root = newNode;
+        else if (oldNode == left(parent(oldNode)))
+            setLeft(parent(oldNode), newNode);
+        else
+            setRight(parent(oldNode), newNode);
+        setParent(newNode, parent(oldNode));
+    }
+
+    void FixDelete(uint32_t node)
+    {
+        while (node != root && !isRed(node))
+        {
+            if (node == left(parent(node)))
+            {
+                uint32_t sibling = right(parent(node));
+                if (isRed(sibling))
+                {
+                    setRed(sibling, false);
+                    setRed(parent(node), true);
+                    leftRotate(parent(node));
+                    sibling = right(parent(node));
+                }
+                if (!isRed(left(sibling)) && !isRed(right(sibling)))
+                {
+                    setRed(sibling, true);
+                    node = parent(node);
+                }
+                else
+                {
+                    if (!isRed(right(sibling)))
+                    {
+                        setRed(left(sibling), false);
+                        setRed(sibling, true);
+                        rightRotate(sibling);
+                        sibling = right(parent(node));
+                    }
+                    setRed(sibling, isRed(parent(node)));
+                    setRed(parent(node), false);
+                    setRed(right(sibling), false);
+                    leftRotate(parent(node));
+                    node = root;
+                }
+            }
+            else
+            {
+                uint32_t sibling = left(parent(node));
+                if (isRed(sibling))
+                {
+                    setRed(sibling, false);
+                    setRed(parent(node), true);
+                    rightRotate(parent(node));
+                    sibling = left(parent(node));
+                }
+                if (!isRed(right(sibling)) && !isRed(left(sibling)))
+                {
+                    setRed(sibling, true);
+                    node = parent(node);
+                }
+                else
+                {
+                    if (!isRed(left(sibling)))
+                    {
+                        setRed(right(sibling), false);
+                        setRed(sibling, true);
+                        leftRotate(sibling);
+                        sibling = left(parent(node));
+                    }
+                    setRed(sibling, isRed(parent(node)));
+                    setRed(parent(node), false);
+                    setRed(left(sibling), false);
+                    rightRotate(parent(node));
+                    node = root;
+                }
+            }
+        }
+        setRed(node, false);
+    }
+
+    void print(uint32_t node, int depth) const
+    {
+        if (node != nil)
+        {
+            for (int i = 0; i < depth; i++)
+                cout << "  ";
+
+            cout << nodes[node].value << (isRed(node) ? "(r)\n" : "(b)\n");
+
+            print(left(node), depth + 1);
+            print(right(node), depth + 1);
+        }
+    }
+
+    // Black height of the subtree, or -1 if it breaks an invariant.
+    int validateSubtree(uint32_t node, uint32_t parentNode, const T *&previous, size_t &visited) const
+    {
+        if (node == nil)
+            return 1;
+        if (++visited > count)
+            return -1;
+        if (parent(node) != parentNode)
+            return -1;
+        if (isRed(node) && (isRed(left(node)) || isRed(right(node))))
+            return -1;
+        int leftHeight = validateSubtree(left(node), node, previous, visited);
+        if (leftHeight < 0 || (previous != nullptr && nodes[node].value < *previous))
+            return -1;
+        previous = &nodes[node].value;
+        int rightHeight = validateSubtree(right(node), node, previous, visited);
+        if (rightHeight != leftHeight)
+            return -1;
+        return leftHeight + (isRed(node) ? 0 : 1);
+    }
+
+public:
+    CompactRedBlackTree()
+    {
+        nodes.push_back(CompactNode<T>{T(), nil, nil, 0});
+    }
+
+    void reserve(size_t capacity)
+    {
+        nodes.reserve(capacity + 1);
+    }
+
+    size_t size() const
+    {
+        return count;
+    }
+
+    // Bytes held by the node array, including unused capacity.
+    size_t memoryUsage() const
+    {
+        return nodes.capacity() * sizeof(CompactNode<T>);
+    }
+
+    void Insert(T value)
+    {
+        uint32_t newNode = createNode(std::move(value));
+        count++;
+
+        uint32_t parentNode = nil;
+        uint32_t current = root;
+        while (current != nil)
+        {
+            parentNode = current;
+            if (nodes[newNode].value < nodes[current].value)
+                current = left(current);
+            else
+                current = right(current);
+        }
+
+        setParent(newNode, parentNode);
+        if (parentNode == nil)
+            root = newNode;
+        else if (nodes[newNode].value < nodes[parentNode].value)
+            setLeft(parentNode, newNode);
+        else
+            setRight(parentNode, newNode);
+
+        FixInsert(newNode);
+    }
+
+    void Delete(T value)
+    {
+        uint32_t target = findNode(value);
+        if (target == nil)
+        {
+            cout << "not found\n";
+            return;
+        }
+
+        uint32_t replacement;
+        bool targetOriginalColor = isRed(target);
+
+        if (left(target) == nil)
+        {
+            replacement = right(target);
+            replaceNode(target, right(target));
+        }
+        else if (right(target) == nil)
+        {
+            replacement = left(target);
+            replaceNode(target, left(target));
+        }
+        else
+        {
+            uint32_t successor = getMinimum(right(target));
+            targetOriginalColor = isRed(successor);
+            replacement = right(successor);
+
+            if (parent(successor) == target)
+                setParent(replacement, successor);
+            else
+            {
+                replaceNode(successor, right(successor));
+                setRight(successor, right(target));
+                setParent(right(successor), successor);
+            }
+
+            replaceNode(target, successor);
+            setLeft(successor, left(target));
+            setParent(left(successor), successor);
+            setRed(successor, isRed(target));
+        }
+
+        if (!targetOriginalColor)
+            FixDelete(replacement);
+
+        nodes[nil].parentAndColor = 0;
+        destroyNode(target);
+        count--;
+    }
+
+    const T *find(const T &value) const
+    {
+        uint32_t node = findNode(value);
+        return node == nil ? nullptr : &nodes[node].value;
+    }
+
+    bool contains(const T &value) const
+    {
+        return findNode(value) != nil;
+    }
+
+    // Checks parent links, order, colors and black heights, and that every
+    // slot is either in the tree or on the free list. For tests, O(n).
+    bool validate() const
+    {
+        if (isRed(nil) || isRed(root))
+            return false;
+        const T *previous = nullptr;
+        size_t visited = 0;
+        if (validateSubtree(root, nil, previous, visited) < 0 || visited != count)
+            return false;
+        size_t freeSlots = 0;
+        for (uint32_t slot = freeList; slot != nil; slot = nodes[slot].left)
+            if (++freeSlots >= nodes.size())
+                return false;
+        return 1 + count + freeSlots == nodes.size();
+    }
+
+    void clear()
+    {
+        nodes.resize(1);
+        nodes[nil].parentAndColor = 0;
+        root = nil;
+        freeList = nil;
+        count = 0;
+    }
+
+    // Dumps the node array as it is, free slots included, so load() needs
+    // no rebuild at all.
+    bool save(const string &path) const
+    {
+        SnapshotWriter<CompactNode<T>> writer(path, CompactNodes);
+        for (const CompactNode<T> &node : nodes)
+            writer.write(node);
+        writer.header().root = root;
+        writer.header().freeList = freeList;
+        writer.header().keyCount = count;
+        return writer.close();
+    }
+
+    // Every link in the file is checked against the slot count first, so
+    // a corrupt snapshot is rejected instead of read out of bounds. Leaves
+    // the tree as it was when the file cannot be used.
+    bool load(const string &path)
+    {
+        MappedSnapshot<CompactNode<T>> snapshot(path, CompactNodes);
+        size_t slots = snapshot.size();
+        if (!snapshot.valid() || slots == 0 || slots > MaxSlots ||
+            snapshot.header().root >= slots || snapshot.header().freeList >= slots ||
+            snapshot.header().keyCount >= slots)
+            return false;
+        for (const CompactNode<T> &node : snapshot)
+            if (node.left >= slots || node.right >= slots || (node.parentAndColor >> 1) >= slots)
+                return false;
+        nodes.assign(snapshot.begin(), snapshot.end());
+        root = (uint32_t)snapshot.header().root;
+        freeList = (uint32_t)snapshot.header().freeList;
+        count = snapshot.header().keyCount;
+        return true;
+    }
+
+    void print() const
+    {
+        print(root, 0);
+    }
+};
+
+#ifndef NO_MAIN
+int main()
+{
+    CompactRedBlackTree<int> tree;
+    tree.Insert(200);
+    tree.Insert(158);
+    tree.Insert(2500);
+    tree.Insert(555);
+    tree.Insert(0);
+    tree.print();
+
+    tree.Delete(50);
+    tree.Delete(200);
+    tree.print();
+
+    cout << "bytes per node: " << sizeof(CompactNode<int>) << endl;
+    return 0;
+}
+#endif
+
+#endif
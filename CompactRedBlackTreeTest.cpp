@@ -0,0 +1,83 @@
+#define NO_MAIN
+#include <iostream>
+#include <cassert>
+#include <random>
+#include <set>
+#include "CompactRedBlackTree.cpp"
+
+void testRandomInsertDelete() {
+    CompactRedBlackTree<int> tree;
+    multiset<int> reference;
+    mt19937 gen(1);
+    for (int i = 0; i < 20000; i++) {
+        int value = gen() % 2000;
+        if (gen() % 3 != 0) {
+            tree.Insert(value);
+            reference.insert(value);
+        }
+        else {
+            tree.Delete(value);
+            auto found = reference.find(value);
+            if (found != reference.end()) {
+                reference.erase(found);
+            }
+        }
+        assert(tree.contains(value) == (reference.count(value) != 0));
+        if (i % 500 == 0) {
+            assert(tree.validate());
+        }
+    }
+    assert(tree.validate());
+    assert(tree.size() == reference.size());
+    for (int value = 0; value < 2000; value++) {
+        assert(tree.contains(value) == (reference.count(value) != 0));
+    }
+}
+
+void testDeleteEverything() {
+    CompactRedBlackTree<int> tree;
+    for (int i = 0; i < 1000; i++) {
+        tree.Insert(i);
+    }
+    for (int i = 0; i < 1000; i += 2) {
+        tree.Delete(i);
+    }
+    assert(tree.validate());
+    for (int i = 1; i < 1000; i += 2) {
+        tree.Delete(i);
+    }
+    assert(tree.validate());
+    assert(tree.size() == 0 && !tree.contains(1));
+}
+
+void testFreeListReuse() {
+    CompactRedBlackTree<int> tree;
+    tree.reserve(1000);
+    for (int i = 0; i < 1000; i++) {
+        tree.Insert(i);
+    }
+    size_t bytes = tree.memoryUsage();
+    for (int round = 0; round < 5; round++) {
+        for (int i = round; i < 1000; i += 2) {
+            tree.Delete(i);
+        }
+        assert(tree.validate());
+        for (int i = round; i < 1000; i += 2) {
+            tree.Insert(i);
+        }
+        assert(tree.validate());
+    }
+    // Every insert took a freed slot, the node array never grew.
+    assert(tree.memoryUsage() == bytes);
+    assert(bytes == 1001 * sizeof(CompactNode<int>));
+    assert(sizeof(CompactNode<int>) == 4 * sizeof(uint32_t));
+    assert(tree.size() == 1000);
+}
+
+int main() {
+    testRandomInsertDelete();
+    testDeleteEverything();
+    testFreeListReuse();
+    std::cout << "All tests passed!" << std::endl;
+    return 0;
+}
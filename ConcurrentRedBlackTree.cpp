@@ -0,0 +1,462 @@
+#ifndef CONCURRENTREDBLACKTREE_CPP
+#define CONCURRENTREDBLACKTREE_CPP
+
+#include <iostream>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <utility>
+#include <vector>
+#include "Epoch.cpp"
+using namespace std;
+
+// Child links are atomics so readers can follow them while a writer
+// relinks. version is odd while a writer is changing the node.
+template <class T>
+struct ConcurrentNode
+{
+    const T value;
+    atomic<ConcurrentNode *> left{nullptr};
+    atomic<ConcurrentNode *> right{nullptr};
+    atomic<uint64_t> version{0};
+    ConcurrentNode *parent = nullptr;
+    bool isRed = true;
+
+    explicit ConcurrentNode(T value) : value(std::move(value)) {}
+};
+
+// Red-black tree for many readers and few writers. Writers take one
+// mutex: a rebalance can rotate all the way up to the root, so finer
+// locks would still meet there. Readers take no lock; they check the
+// version of every node they pass and start again from the root when a
+// writer touched it. Removed nodes are freed through EpochManager once no
+// reader can still hold them.
+template <class T>
+class ConcurrentRedBlackTree
+{
+    typedef ConcurrentNode<T> NodeType;
+
+    atomic<NodeType *> root{nullptr};
+    atomic<size_t> nodeCount{0};
+    mutex writeLock;
+    EpochManager epochs;
+
+    // Nodes the running write has made odd, published again in endWrite().
+    vector<NodeType *> dirty;
+
+    void markDirty(NodeType *node)
+    {
+        if (node == nullptr)
+            return;
+        uint64_t version = node->version.load(memory_order_relaxed);
+        if (version & 1)
+            return;
+        node->version.store(version + 1, memory_order_relaxed);
+        atomic_thread_fence(memory_order_release);
+        dirty.push_back(node);
+    }
+
+    void endWrite()
+    {
+        for (NodeType *node : dirty)
+            node->version.store(node->version.load(memory_order_relaxed) + 1, memory_order_release);
+        dirty.clear();
+    }
+
+    static NodeType *leftOf(NodeType *node) { return node->left.load(memory_order_relaxed); }
+    static NodeType *rightOf(NodeType *node) { return node->right.load(memory_order_relaxed); }
+    static bool isRedNode(NodeType *node) { return node != nullptr && node->isRed; }
+
+    void setLeft(NodeType *node, NodeType *child)
+    {
+        markDirty(node);
+        node->left.store(child, memory_order_release);
+    }
+
+    void setRight(NodeType *node, NodeType *child)
+    {
+        markDirty(node);
+        node->right.store(child, memory_order_release);
+    }
+
+    void setRoot(NodeType *node)
+    {
+        root.store(node, memory_order_release);
+    }
+
+    void replaceChild(NodeType *parent, NodeType *oldChild, NodeType *newChild)
+    {
+        if (parent == nullptr)
+            setRoot(newChild);
+        else if (oldChild == leftOf(parent))
+            setLeft(parent, newChild);
+        else
+            setRight(parent, newChild);
+    }
+
+    void leftRotate(NodeType *node)
+    {
+        NodeType *newParent = rightOf(node);
+        markDirty(newParent);
+        setRight(node, leftOf(newParent));
+        if (leftOf(newParent) != nullptr)
+            leftOf(newParent)->parent = node;
+
+        newParent->parent = node->parent;
+        replaceChild(node->parent, node, newParent);
+
+        setLeft(newParent, node);
+        node->parent = newParent;
+    }
+
+    void rightRotate(NodeType *node)
+    {
+        NodeType *newParent = leftOf(node);
+        markDirty(newParent);
+        setLeft(node, rightOf(newParent));
+        if (rightOf(newParent) != nullptr)
+            rightOf(newParent)->parent = node;
+
+        newParent->parent = node->parent;
+        replaceChild(node->parent, node, newParent);
+
+        setRight(newParent, node);
+        node->parent = newParent;
+    }
+
+    void FixInsert(NodeType *node)
+    {
+        while (node != root.load(memory_order_relaxed) && node->parent->isRed)
+        {
+            NodeType *grandParent = node->parent->parent;
+            if (node->parent == leftOf(grandParent))
+            {
+                NodeType *uncle = rightOf(grandParent);
+                if (isRedNode(uncle))
+                {
+                    node->parent->isRed = false;
+                    uncle->isRed = false;
+                    grandParent->isRed = true;
+                    node = grandParent;
+                }
+                else
+                {
+                    if (node == rightOf(node->parent))
+                    {
+                        node = node->parent;
+                        leftRotate(node);
+                    }
+                    node->parent->isRed = false;
+                    node->parent->parent->isRed = true;
+                    rightRotate(node->parent->parent);
+                }
+            }
+            else
+            {
+                NodeType *uncle = leftOf(grandParent);
+                if (isRedNode(uncle))
+                {
+                    node->parent->isRed = false;
+                    uncle->isRed = false;
+                    grandParent->isRed = true;
+                    node = grandParent;
+                }
+                else
+                {
+                    if (node == leftOf(node->parent))
+                    {
+                        node = node->parent;
+                        rightRotate(node);
+                    }
+                    node->parent->isRed = false;
+                    node->parent->parent->isRed = true;
+                    leftRotate(node->parent->parent);
+                }
+            }
+        }
+        root.load(memory_order_relaxed)->isRed = false;
+    }
+
+    void FixDelete(NodeType *node, NodeType *parent)
+    {
+        while (node != root.load(memory_order_relaxed) && !isRedNode(node))
+        {
+            if (node == leftOf(parent))
+            {
+                NodeType *sibling = rightOf(parent);
+                if (isRedNode(sibling))
+                {
+                    sibling->isRed = false;
+                    parent->isRed = true;
+                    leftRotate(parent);
+                    sibling = rightOf(parent);
+                }
+                if (!isRedNode(leftOf(sibling)) && !isRedNode(rightOf(sibling)))
+                {
+                    sibling->isRed = true;
+                    node = parent;
+                    parent = node->parent;
+                }
+                else
+                {
+                    if (!isRedNode(rightOf(sibling)))
+                    {
+                        leftOf(sibling)->isRed = false;
+                        sibling->isRed = true;
+                        rightRotate(sibling);
+                        sibling = rightOf(parent);
+                    }
+                    sibling->isRed = parent->isRed;
+                    parent->isRed = false;
+                    if (rightOf(sibling) != nullptr)
+                        rightOf(sibling)->isRed = false;
+                    leftRotate(parent);
+                    node = root.load(memory_order_relaxed);
+                }
+            }
+            else
+            {
+                NodeType *sibling = leftOf(parent);
+                if (isRedNode(sibling))
+                {
+                    sibling->isRed = false;
+                    parent->isRed = true;
+                    rightRotate(parent);
+                    sibling = leftOf(parent);
+                }
+                if (!isRedNode(rightOf(sibling)) && !isRedNode(leftOf(sibling)))
+                {
+                    sibling->isRed = true;
+                    node = parent;
+                    parent = node->parent;
+                }
+                else
+                {
+                    if (!isRedNode(leftOf(sibling)))
+                    {
+                        rightOf(sibling)->isRed = false;
+                        sibling->isRed = true;
+                        leftRotate(sibling);
+                        sibling = leftOf(parent);
+                    }
+                    sibling->isRed = parent->isRed;
+                    parent->isRed = false;
+                    if (leftOf(sibling) != nullptr)
+                        leftOf(sibling)->isRed = false;
+                    rightRotate(parent);
+                    node = root.load(memory_order_relaxed);
+                }
+            }
+        }
+        if (node != nullptr)
+            node->isRed = false;
+    }
+
+    NodeType *findForWrite(const T &value) const
+    {
+        NodeType *current = root.load(memory_order_relaxed);
+        while (current != nullptr)
+        {
+            if (value < current->value)
+                current = leftOf(current);
+            else if (current->value < value)
+                current = rightOf(current);
+            else
+                return current;
+        }
+        return nullptr;
+    }
+
+    enum ReadResult
+    {
+        Missing,
+        Found,
+        Retry
+    };
+
+    // One optimistic descent. Before moving to a child the reader reads
+    // the child's version and checks the parent's is unchanged, so every
+    // step was a real link at some instant.
+    ReadResult tryFind(const T &value) const
+    {
+        NodeType *node = root.load(memory_order_acquire);
+        if (node == nullptr)
+            return Missing;
+        uint64_t version = node->version.load(memory_order_acquire);
+        if ((version & 1) || node != root.load(memory_order_acquire))
+            return Retry;
+
+        while (true)
+        {
+            if (!(value < node->value) && !(node->value < value))
+                return Found;
+
+            NodeType *child = value < node->value ? node->left.load(memory_order_acquire)
+                                                  : node->right.load(memory_order_acquire);
+            uint64_t childVersion = child != nullptr ? child->version.load(memory_order_acquire) : 0;
+            atomic_thread_fence(memory_order_acquire);
+            if (node->version.load(memory_order_relaxed) != version)
+                return Retry;
+            if (child == nullptr)
+                return Missing;
+            if (childVersion & 1)
+                return Retry;
+            node = child;
+            version = childVersion;
+        }
+    }
+
+    void destroyAll(NodeType *node)
+    {
+        while (node != nullptr)
+        {
+            destroyAll(leftOf(node));
+            NodeType *right = rightOf(node);
+            delete node;
+            node = right;
+        }
+    }
+
+public:
+    ConcurrentRedBlackTree() {}
+    ConcurrentRedBlackTree(const ConcurrentRedBlackTree &) = delete;
+    ConcurrentRedBlackTree &operator=(const ConcurrentRedBlackTree &) = delete;
+
+    // Needs every reader and writer to be finished.
+    ~ConcurrentRedBlackTree()
+    {
+        epochs.drain();
+        destroyAll(root.load());
+    }
+
+    size_t size() const
+    {
+        return nodeCount.load(memory_order_relaxed);
+    }
+
+    // Lock free, safe to call while other threads write.
+    bool contains(const T &value)
+    {
+        EpochManager::Guard guard(epochs);
+        while (true)
+        {
+            ReadResult result = tryFind(value);
+            if (result != Retry)
+                return result == Found;
+        }
+    }
+
+    void Insert(T value)
+    {
+        NodeType *newNode = new NodeType(std::move(value));
+        lock_guard<mutex> guard(writeLock);
+
+        NodeType *parent = nullptr;
+        NodeType *current = root.load(memory_order_relaxed);
+        while (current != nullptr)
+        {
+            parent = current;
+            current = newNode->value < current->value ? leftOf(current) : rightOf(current);
+        }
+
+        newNode->parent = parent;
+        if (parent == nullptr)
+            setRoot(newNode);
+        else if (newNode->value < parent->value)
+            setLeft(parent, newNode);
+        else
+            setRight(parent, newNode);
+
+        FixInsert(newNode);
+        endWrite();
+        nodeCount.fetch_add(1, memory_order_relaxed);
+    }
+
+    // Returns false when value is not in the tree.
+    bool Delete(const T &value)
+    {
+        lock_guard<mutex> guard(writeLock);
+        NodeType *target = findForWrite(value);
+        if (target == nullptr)
+            return false;
+
+        markDirty(target);
+        NodeType *replacement;
+        NodeType *replacementParent;
+        bool targetOriginalColor = target->isRed;
+
+        if (leftOf(target) == nullptr || rightOf(target) == nullptr)
+        {
+            replacement = leftOf(target) == nullptr ? rightOf(target) : leftOf(target);
+            replacementParent = target->parent;
+            replaceChild(target->parent, target, replacement);
+            if (replacement != nullptr)
+                replacement->parent = target->parent;
+        }
+        else
+        {
+            // The successor moves up, every node it leaves behind loses
+            // a key and must send readers back to the root.
+            NodeType *successor = rightOf(target);
+            markDirty(successor);
+            while (leftOf(successor) != nullptr)
+            {
+                successor = leftOf(successor);
+                markDirty(successor);
+            }
+            targetOriginalColor = successor->isRed;
+            replacement = rightOf(successor);
+            replacementParent = successor;
+
+            if (successor->parent != target)
+            {
+                replacementParent = successor->parent;
+                replaceChild(successor->parent, successor, replacement);
+                if (replacement != nullptr)
+                    replacement->parent = successor->parent;
+                setRight(successor, rightOf(target));
+                rightOf(successor)->parent = successor;
+            }
+
+            replaceChild(target->parent, target, successor);
+            successor->parent = target->parent;
+            setLeft(successor, leftOf(target));
+            leftOf(successor)->parent = successor;
+            successor->isRed = target->isRed;
+        }
+
+        if (!targetOriginalColor)
+            FixDelete(replacement, replacementParent);
+
+        endWrite();
+        nodeCount.fetch_sub(1, memory_order_relaxed);
+        epochs.retire(target);
+        return true;
+    }
+};
+
+#ifndef NO_MAIN
+int main()
+{
+    ConcurrentRedBlackTree<int> tree;
+    vector<thread> writers;
+    for (int w = 0; w < 2; w++)
+        writers.push_back(thread([&tree, w]()
+                                 {
+                                     for (int i = w; i < 10000; i += 2)
+                                         tree.Insert(i); }));
+    size_t hits = 0;
+    for (int i = 0; i < 10000; i++)
+        hits += tree.contains(i);
+    for (thread &writer : writers)
+        writer.join();
+
+    for (int i = 0; i < 10000; i += 3)
+        tree.Delete(i);
+    cout << "size: " << tree.size() << ", contains 3: " << tree.contains(3)
+         << ", contains 4: " << tree.contains(4) << ", seen while inserting: " << hits << endl;
+    return 0;
+}
+#endif
+
+#endif
@@ -0,0 +1,94 @@
+#define NO_MAIN
+#include <iostream>
+#include <atomic>
+#include <cassert>
+#include <random>
+#include <set>
+#include <thread>
+#include <vector>
+#include "ConcurrentRedBlackTree.cpp"
+
+void testSingleThreaded() {
+    ConcurrentRedBlackTree<int> tree;
+    set<int> reference;
+    mt19937 gen(1);
+    for (int i = 0; i < 20000; i++) {
+        int value = gen() % 2000;
+        if (gen() % 2 == 0) {
+            if (reference.insert(value).second) {
+                tree.Insert(value);
+            }
+        }
+        else {
+            assert(tree.Delete(value) == (reference.erase(value) == 1));
+        }
+        assert(tree.contains(value) == (reference.count(value) == 1));
+    }
+    assert(tree.size() == reference.size());
+    for (int value = 0; value < 2000; value++) {
+        assert(tree.contains(value) == (reference.count(value) == 1));
+    }
+}
+
+// Multiples of 4 are inserted up front and never deleted. The writer keeps
+// deleting and reinserting everything else, which rotates and recolors
+// the nodes the readers are walking through and retires removed nodes.
+void testReadersNeverMissStableKeys() {
+    const int keyCount = 4000;
+    ConcurrentRedBlackTree<int> tree;
+    for (int i = 0; i < keyCount; i++) {
+        tree.Insert(i);
+    }
+
+    atomic<bool> done{false};
+    atomic<long> lookups{0};
+    vector<thread> readers;
+    for (int r = 0; r < 3; r++) {
+        readers.push_back(thread([&tree, &done, &lookups, r]() {
+            mt19937 gen(r);
+            while (!done.load(memory_order_acquire)) {
+                int key = (int)(gen() % (keyCount / 4)) * 4;
+                assert(tree.contains(key));
+                tree.contains(key + 1 + (int)(gen() % 3));
+                lookups.fetch_add(1, memory_order_relaxed);
+            }
+        }));
+    }
+
+    // The writer also keeps going until the readers got a fair share of
+    // lookups in, so they overlap it even on a single core.
+    thread writer([&tree, &lookups]() {
+        mt19937 gen(7);
+        for (int round = 0; round < 20 || lookups.load(memory_order_relaxed) < 200000; round++) {
+            for (int i = 0; i < keyCount; i++) {
+                if (i % 4 != 0 && gen() % 2 == 0) {
+                    assert(tree.Delete(i));
+                    tree.Insert(i);
+                }
+            }
+            for (int i = keyCount; i < keyCount + 500; i++) {
+                tree.Insert(i);
+            }
+            for (int i = keyCount; i < keyCount + 500; i++) {
+                assert(tree.Delete(i));
+            }
+        }
+    });
+    writer.join();
+    done.store(true, memory_order_release);
+    for (thread &reader : readers) {
+        reader.join();
+    }
+
+    assert(tree.size() == (size_t)keyCount);
+    for (int i = 0; i < keyCount + 500; i++) {
+        assert(tree.contains(i) == (i < keyCount));
+    }
+}
+
+int main() {
+    testSingleThreaded();
+    testReadersNeverMissStableKeys();
+    std::cout << "All tests passed!" << std::endl;
+    return 0;
+}
@@ -0,0 +1,331 @@
+#ifndef CONCURRENTSKIPLIST_CPP
+#define CONCURRENTSKIPLIST_CPP
+
+#include <iostream>
+#include <atomic>
+#include <cstdint>
+#include <new>
+#include <optional>
+#include <thread>
+#include <vector>
+#include "Epoch.cpp"
+#include "SkipListLevels.cpp"
+using namespace std;
+
+// Forward links are words holding the next node with the low bit as the
+// deleted mark: a node whose link is marked on a level is being removed
+// and no longer accepts successors there. The links follow the node in
+// the same block, as in SkipListNode.
+template <class T>
+class ConcurrentSkipListNode
+{
+    static size_t towerOffset()
+    {
+        const size_t linkAlign = alignof(atomic<uintptr_t>);
+        return (sizeof(ConcurrentSkipListNode<T>) + linkAlign - 1) / linkAlign * linkAlign;
+    }
+
+    ConcurrentSkipListNode(const T &value, int levelCount) : value(value), levelCount(levelCount)
+    {
+        for (int level = 0; level < levelCount; level++)
+            new (&links()[level]) atomic<uintptr_t>(0);
+    }
+
+public:
+    const T value;
+    const int levelCount;
+    // Raised once by the inserter when it stops linking the tower and once
+    // by the remover after unlinking it; whoever comes second retires it.
+    atomic<int> handoff{0};
+
+    atomic<uintptr_t> *links()
+    {
+        return reinterpret_cast<atomic<uintptr_t> *>(reinterpret_cast<char *>(this) + towerOffset());
+    }
+
+    static ConcurrentSkipListNode<T> *create(const T &value, int levelCount)
+    {
+        void *memory = ::operator new(towerOffset() + levelCount * sizeof(atomic<uintptr_t>));
+        return new (memory) ConcurrentSkipListNode<T>(value, levelCount);
+    }
+
+    static void destroy(void *pointer)
+    {
+        ConcurrentSkipListNode<T> *node = static_cast<ConcurrentSkipListNode<T> *>(pointer);
+        node->~ConcurrentSkipListNode<T>();
+        ::operator delete(pointer);
+    }
+};
+
+// Lock-free skip list set. insert and remove change links with CAS only:
+// remove marks the tower top down and the thread whose mark lands on
+// level 0 owns the removal; every search unlinks the marked nodes it
+// passes. Lookups never write. Removed nodes are freed through
+// EpochManager once no operation can still hold them. Tower heights come
+// from one LevelGenerator per EpochManager slot, seeded from the list's
+// seed and the slot index, so a seeded list repeats its towers.
+template <class T, class LevelGenerator = HalfLevels>
+class ConcurrentSkipList
+{
+    typedef ConcurrentSkipListNode<T> NodeType;
+    static const int MaxLevel = SkipListMaxLevel;
+
+    // A Guard owns its slot until it ends, so only the thread holding it
+    // draws from that slot's generator.
+    struct alignas(64) LevelSlot
+    {
+        LevelGenerator levels;
+        explicit LevelSlot(const LevelGenerator &levels) : levels(levels) {}
+    };
+
+    NodeType *head;
+    vector<LevelSlot> levelSlots;
+    // Levels in use; only grows, starting lower just skips shortcuts.
+    atomic<int> levelHint{1};
+    atomic<int> count{0};
+    mutable EpochManager epochs;
+
+    static bool isMarked(uintptr_t link)
+    {
+        return link & 1;
+    }
+
+    static NodeType *nodeOf(uintptr_t link)
+    {
+        return reinterpret_cast<NodeType *>(link & ~(uintptr_t)1);
+    }
+
+    static uintptr_t linkTo(NodeType *node)
+    {
+        return reinterpret_cast<uintptr_t>(node);
+    }
+
+    int randomLevelCount(const EpochManager::Guard &guard)
+    {
+        return levelSlots[guard.index()].levels.next();
+    }
+
+    int startLevel(int atLeast) const
+    {
+        int hint = levelHint.load(memory_order_acquire);
+        return (hint > atLeast ? hint : atLeast) - 1;
+    }
+
+    // Fills preds/succs from top down to level 0 around value, unlinking
+    // the marked nodes met on the way. With sweep it keeps going past nodes
+    // equal to value, so every marked copy of value gets unlinked. Returns
+    // the first node not less than value on level 0.
+    NodeType *find(const T &value, NodeType **preds, NodeType **succs, int top, bool sweep = false)
+    {
+    retry:
+        NodeType *pred = head;
+        NodeType *curr = nullptr;
+        for (int level = top; level >= 0; level--)
+        {
+            curr = nodeOf(pred->links()[level].load(memory_order_acquire));
+            while (curr != nullptr)
+            {
+                uintptr_t succ = curr->links()[level].load(memory_order_acquire);
+                if (isMarked(succ))
+                {
+                    uintptr_t expected = linkTo(curr);
+                    if (!pred->links()[level].compare_exchange_strong(expected, linkTo(nodeOf(succ))))
+                        goto retry;
+                    curr = nodeOf(succ);
+                }
+                else if (curr->value < value || (sweep && !(value < curr->value)))
+                {
+                    pred = curr;
+                    curr = nodeOf(succ);
+                }
+                else
+                    break;
+            }
+            preds[level] = pred;
+            succs[level] = curr;
+        }
+        return curr;
+    }
+
+    void finishWith(NodeType *node)
+    {
+        if (node->handoff.fetch_add(1, memory_order_acq_rel) == 1)
+            epochs.retire(node, &NodeType::destroy);
+    }
+
+public:
+    explicit ConcurrentSkipList(uint64_t seed = randomLevelSeed(), size_t expectedSize = 0)
+        : head(NodeType::create(T(), MaxLevel))
+    {
+        levelSlots.reserve(EpochManager::MaxSlots);
+        for (int slot = 0; slot < EpochManager::MaxSlots; slot++)
+            levelSlots.emplace_back(LevelGenerator(mixSeed(seed, slot), expectedSize));
+    }
+    ConcurrentSkipList(const ConcurrentSkipList &) = delete;
+    ConcurrentSkipList &operator=(const ConcurrentSkipList &) = delete;
+
+    // Only when no other thread uses the list any more.
+    ~ConcurrentSkipList()
+    {
+        NodeType *node = nodeOf(head->links()[0].load(memory_order_relaxed));
+        while (node != nullptr)
+        {
+            NodeType *next = nodeOf(node->links()[0].load(memory_order_relaxed));
+            NodeType::destroy(node);
+            node = next;
+        }
+        NodeType::destroy(head);
+    }
+
+    int getCount() const
+    {
+        return count.load(memory_order_relaxed);
+    }
+
+    // false when an equal value is already present.
+    bool insert(const T &value)
+    {
+        EpochManager::Guard guard(epochs);
+        NodeType *preds[MaxLevel];
+        NodeType *succs[MaxLevel];
+        const int levelCount = randomLevelCount(guard);
+        const int top = startLevel(levelCount);
+        NodeType *node = nullptr;
+        while (true)
+        {
+            NodeType *found = find(value, preds, succs, top);
+            if (found != nullptr && !(value < found->value))
+            {
+                if (node != nullptr)
+                    NodeType::destroy(node);
+                return false;
+            }
+            if (node == nullptr)
+                node = NodeType::create(value, levelCount);
+            for (int level = 0; level < levelCount; level++)
+                node->links()[level].store(linkTo(succs[level]), memory_order_relaxed);
+            uintptr_t expected = linkTo(succs[0]);
+            if (preds[0]->links()[0].compare_exchange_strong(expected, linkTo(node)))
+                break;
+        }
+        count.fetch_add(1, memory_order_relaxed);
+        int hint = levelHint.load(memory_order_relaxed);
+        while (hint < levelCount && !levelHint.compare_exchange_weak(hint, levelCount))
+        {
+        }
+
+        for (int level = 1; level < levelCount; level++)
+        {
+            while (true)
+            {
+                uintptr_t link = node->links()[level].load(memory_order_acquire);
+                if (isMarked(link))
+                    goto linked;
+                if (nodeOf(link) != succs[level] &&
+                    !node->links()[level].compare_exchange_strong(link, linkTo(succs[level])))
+                    goto linked;
+                uintptr_t expected = linkTo(succs[level]);
+                if (preds[level]->links()[level].compare_exchange_strong(expected, linkTo(node)))
+                    break;
+                find(value, preds, succs, top);
+            }
+        }
+    linked:
+        // A remover that marked the node before an upper level was linked
+        // may have swept already, so unlink it again here.
+        if (isMarked(node->links()[0].load(memory_order_acquire)))
+            find(value, preds, succs, top, true);
+        finishWith(node);
+        return true;
+    }
+
+    // false when value is not present.
+    bool remove(const T &value)
+    {
+        EpochManager::Guard guard(epochs);
+        NodeType *preds[MaxLevel];
+        NodeType *succs[MaxLevel];
+        NodeType *node = find(value, preds, succs, startLevel(1));
+        if (node == nullptr || value < node->value)
+            return false;
+
+        for (int level = node->levelCount - 1; level > 0; level--)
+            node->links()[level].fetch_or(1, memory_order_acq_rel);
+        if (isMarked(node->links()[0].fetch_or(1, memory_order_acq_rel)))
+            return false;
+
+        count.fetch_sub(1, memory_order_relaxed);
+        find(value, preds, succs, startLevel(node->levelCount), true);
+        finishWith(node);
+        return true;
+    }
+
+    // Copy of the stored element equal to value, if any.
+    optional<T> find(const T &value) const
+    {
+        EpochManager::Guard guard(epochs);
+        NodeType *pred = head;
+        NodeType *curr = nullptr;
+        for (int level = startLevel(1); level >= 0; level--)
+        {
+            curr = nodeOf(pred->links()[level].load(memory_order_acquire));
+            while (curr != nullptr && curr->value < value)
+            {
+                pred = curr;
+                curr = nodeOf(curr->links()[level].load(memory_order_acquire));
+            }
+        }
+        if (curr == nullptr || value < curr->value || isMarked(curr->links()[0].load(memory_order_acquire)))
+            return nullopt;
+        return curr->value;
+    }
+
+    bool exists(const T &value) const
+    {
+        return find(value).has_value();
+    }
+
+    // Calls visit on every element in order. Weakly consistent: elements
+    // inserted or removed during the walk may or may not be seen.
+    template <class Visitor>
+    void forEach(Visitor visit) const
+    {
+        EpochManager::Guard guard(epochs);
+        for (NodeType *node = nodeOf(head->links()[0].load(memory_order_acquire)); node != nullptr;)
+        {
+            uintptr_t next = node->links()[0].load(memory_order_acquire);
+            if (!isMarked(next))
+                visit(node->value);
+            node = nodeOf(next);
+        }
+    }
+};
+
+#ifndef NO_MAIN
+int main()
+{
+    ConcurrentSkipList<int> list;
+    vector<thread> writers;
+    for (int w = 0; w < 4; w++)
+        writers.push_back(thread([&list, w]()
+                                 {
+                                     for (int i = w; i < 20000; i += 4)
+                                         list.insert(i);
+                                     for (int i = w; i < 20000; i += 12)
+                                         list.remove(i); }));
+    size_t hits = 0;
+    for (int i = 0; i < 20000; i++)
+        hits += list.exists(i);
+    for (thread &writer : writers)
+        writer.join();
+
+    long long sum = 0;
+    list.forEach([&sum](int value)
+                 { sum += value; });
+    cout << "count: " << list.getCount() << ", exists 3: " << list.exists(3) << ", exists 4: " << list.exists(4)
+         << ", sum: " << sum << ", seen while writing: " << hits << endl;
+    return 0;
+}
+#endif
+
+#endif
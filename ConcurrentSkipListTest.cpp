@@ -0,0 +1,193 @@
+#define NO_MAIN
+#include <iostream>
+#include <cassert>
+#include <atomic>
+#include <random>
+#include <set>
+#include <thread>
+#include <vector>
+#include "ConcurrentSkipList.cpp"
+
+// forEach visits a strictly increasing sequence equal to reference, and as
+// many elements as getCount() reports.
+void checkList(ConcurrentSkipList<int> &list, const set<int> &reference) {
+    vector<int> visited;
+    list.forEach([&](const int &value) { visited.push_back(value); });
+    for (size_t i = 1; i < visited.size(); i++) {
+        assert(visited[i - 1] < visited[i]);
+    }
+    assert((int)visited.size() == list.getCount());
+    assert(equal(visited.begin(), visited.end(), reference.begin(), reference.end()));
+}
+
+void testSingleThread() {
+    ConcurrentSkipList<int> list(1);
+    set<int> reference;
+    mt19937 gen(1);
+    for (int i = 0; i < 50000; i++) {
+        int value = gen() % 2000;
+        int op = gen() % 3;
+        if (op == 0) {
+            assert(list.insert(value) == reference.insert(value).second);
+        }
+        else if (op == 1) {
+            assert(list.remove(value) == (reference.erase(value) == 1));
+        }
+        else {
+            optional<int> found = list.find(value);
+            assert(list.exists(value) == (reference.count(value) == 1));
+            assert(found.has_value() == (reference.count(value) == 1));
+            assert(!found || *found == value);
+        }
+    }
+    checkList(list, reference);
+}
+
+// Writers share a small key space. Each one owns the keys congruent to its
+// index, so it knows exactly what exists() and insert() must return for
+// them, while all of them also race on a few keys owned by nobody. Every
+// successful insert of a shared key adds one to its balance and every
+// successful remove takes one away, so the balance ends at 0 or 1 and
+// says whether the key is present.
+void testConcurrentWriters() {
+    const int writers = 4;
+    const int ownedKeys = 256;
+    const int sharedKeys = 8;
+    const int rounds = 200000;
+    ConcurrentSkipList<int> list(2);
+    atomic<int> balance[sharedKeys];
+    for (atomic<int> &b : balance) {
+        b = 0;
+    }
+    vector<set<int>> owned(writers);
+    atomic<int> started{0};
+
+    vector<thread> threads;
+    for (int w = 0; w < writers; w++) {
+        threads.emplace_back([&, w] {
+            mt19937 gen(10 + w);
+            vector<bool> present(ownedKeys, false);
+            started++;
+            while (started < writers) {
+                this_thread::yield();
+            }
+            for (int i = 0; i < rounds; i++) {
+                if (gen() % 4 == 0) {
+                    int key = ownedKeys + gen() % sharedKeys;
+                    if (gen() % 2 == 0) {
+                        if (list.insert(key)) {
+                            balance[key - ownedKeys]++;
+                        }
+                    }
+                    else if (list.remove(key)) {
+                        balance[key - ownedKeys]--;
+                    }
+                    continue;
+                }
+                int slot = gen() % (ownedKeys / writers);
+                int key = slot * writers + w;
+                bool existed = list.exists(key);
+                assert(existed == present[key]);
+                if (gen() % 2 == 0) {
+                    assert(list.insert(key) == !existed);
+                    present[key] = true;
+                }
+                else {
+                    assert(list.remove(key) == existed);
+                    present[key] = false;
+                }
+            }
+            for (int key = w; key < ownedKeys; key += writers) {
+                if (present[key]) {
+                    owned[w].insert(key);
+                }
+            }
+        });
+    }
+    for (thread &t : threads) {
+        t.join();
+    }
+
+    set<int> reference;
+    for (const set<int> &keys : owned) {
+        reference.insert(keys.begin(), keys.end());
+    }
+    for (int k = 0; k < sharedKeys; k++) {
+        assert(balance[k] == 0 || balance[k] == 1);
+        assert(list.exists(ownedKeys + k) == (balance[k] == 1));
+        if (balance[k] == 1) {
+            reference.insert(ownedKeys + k);
+        }
+    }
+    checkList(list, reference);
+}
+
+// Readers walk the list while writers churn the odd keys; the even keys
+// are never touched, so every walk sees all of them in order.
+void testReadersDuringWrites() {
+    const int stableKeys = 500;
+    ConcurrentSkipList<int> list(3);
+    for (int i = 0; i < stableKeys; i++) {
+        list.insert(2 * i);
+    }
+    atomic<int> readersDone{0};
+    atomic<int> walks{0};
+
+    vector<thread> threads;
+    for (int w = 0; w < 2; w++) {
+        threads.emplace_back([&, w] {
+            mt19937 gen(20 + w);
+            // Keep writing until the readers are done, so they overlap
+            // even when the threads end up on one core.
+            while (readersDone < 2) {
+                int key = 2 * (gen() % stableKeys) + 1;
+                if (gen() % 2 == 0) {
+                    list.insert(key);
+                }
+                else {
+                    list.remove(key);
+                }
+            }
+        });
+    }
+    for (int r = 0; r < 2; r++) {
+        threads.emplace_back([&] {
+            for (int i = 0; i < 200; i++) {
+                int previous = -1;
+                int evens = 0;
+                list.forEach([&](const int &value) {
+                    assert(value > previous);
+                    previous = value;
+                    if (value % 2 == 0) {
+                        evens++;
+                    }
+                });
+                assert(evens == stableKeys);
+                for (int key = 0; key < 2 * stableKeys; key += 50) {
+                    assert(list.exists(key));
+                }
+                walks++;
+            }
+            readersDone++;
+        });
+    }
+    for (thread &t : threads) {
+        t.join();
+    }
+    assert(walks == 400);
+
+    set<int> reference;
+    list.forEach([&](const int &value) { reference.insert(value); });
+    checkList(list, reference);
+    for (int i = 0; i < stableKeys; i++) {
+        assert(reference.count(2 * i) == 1);
+    }
+}
+
+int main() {
+    testSingleThread();
+    testConcurrentWriters();
+    testReadersDuringWrites();
+    std::cout << "All tests passed!" << std::endl;
+    return 0;
+}
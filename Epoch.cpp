@@ -0,0 +1,159 @@
+#ifndef EPOCH_CPP
+#define EPOCH_CPP
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+using namespace std;
+
+// Epoch based reclamation. A reader announces the global epoch while it
+// holds a Guard; memory retired by a writer is freed once every announced
+// epoch is newer than the epoch it was retired in, because no reader that
+// started after the unlink can reach it.
+class EpochManager
+{
+public:
+    // Most threads that can hold a Guard at the same time.
+    static const int MaxSlots = 256;
+
+private:
+    static const uint64_t Idle = ~0ull;
+
+    struct alignas(64) Slot
+    {
+        atomic<uint64_t> epoch{Idle};
+        atomic<bool> used{false};
+    };
+
+    struct Retired
+    {
+        uint64_t epoch;
+        void *pointer;
+        void (*destroy)(void *);
+    };
+
+    Slot slots[MaxSlots];
+    atomic<uint64_t> globalEpoch{1};
+    mutex retiredLock;
+    vector<Retired> retired;
+    size_t reclaimThreshold = 64;
+
+    int claimSlot()
+    {
+        static atomic<int> nextHint{0};
+        thread_local int hint = nextHint.fetch_add(1) % MaxSlots;
+        for (int i = 0;; i++)
+        {
+            int index = (hint + i) % MaxSlots;
+            bool expected = false;
+            if (!slots[index].used.load(memory_order_relaxed) &&
+                slots[index].used.compare_exchange_strong(expected, true, memory_order_acquire))
+            {
+                hint = index;
+                return index;
+            }
+            if (i > 0 && i % MaxSlots == 0)
+                this_thread::yield();
+        }
+    }
+
+    uint64_t oldestActiveEpoch()
+    {
+        atomic_thread_fence(memory_order_seq_cst);
+        uint64_t oldest = Idle;
+        for (int i = 0; i < MaxSlots; i++)
+        {
+            uint64_t epoch = slots[i].epoch.load(memory_order_acquire);
+            if (epoch < oldest)
+                oldest = epoch;
+        }
+        return oldest;
+    }
+
+    // Caller holds retiredLock.
+    void reclaim()
+    {
+        globalEpoch.fetch_add(1);
+        uint64_t oldest = oldestActiveEpoch();
+        size_t kept = 0;
+        for (size_t i = 0; i < retired.size(); i++)
+        {
+            if (retired[i].epoch < oldest)
+                retired[i].destroy(retired[i].pointer);
+            else
+                retired[kept++] = retired[i];
+        }
+        retired.resize(kept);
+        reclaimThreshold = kept * 2 > 64 ? kept * 2 : 64;
+    }
+
+public:
+    class Guard
+    {
+        EpochManager &manager;
+        int slot;
+
+    public:
+        explicit Guard(EpochManager &manager) : manager(manager), slot(manager.claimSlot())
+        {
+            manager.slots[slot].epoch.store(manager.globalEpoch.load(memory_order_relaxed), memory_order_relaxed);
+            atomic_thread_fence(memory_order_seq_cst);
+        }
+
+        Guard(const Guard &) = delete;
+        Guard &operator=(const Guard &) = delete;
+
+        // Slot owned by this guard, in [0, MaxSlots); no other guard of the
+        // same manager has it until this one ends.
+        int index() const
+        {
+            return slot;
+        }
+
+        ~Guard()
+        {
+            manager.slots[slot].epoch.store(Idle, memory_order_release);
+            manager.slots[slot].used.store(false, memory_order_release);
+        }
+    };
+
+    EpochManager() {}
+    EpochManager(const EpochManager &) = delete;
+    EpochManager &operator=(const EpochManager &) = delete;
+
+    // Frees pointer with destroy once no reader can still see it. Call it
+    // after pointer has been unlinked from the shared structure.
+    void retire(void *pointer, void (*destroy)(void *))
+    {
+        atomic_thread_fence(memory_order_seq_cst);
+        lock_guard<mutex> guard(retiredLock);
+        retired.push_back(Retired{globalEpoch.load(), pointer, destroy});
+        if (retired.size() >= reclaimThreshold)
+            reclaim();
+    }
+
+    template <class Object>
+    void retire(Object *object)
+    {
+        retire(object, [](void *pointer)
+               { delete static_cast<Object *>(pointer); });
+    }
+
+    // Frees everything at once, only when no reader is left.
+    void drain()
+    {
+        lock_guard<mutex> guard(retiredLock);
+        for (Retired &entry : retired)
+            entry.destroy(entry.pointer);
+        retired.clear();
+    }
+
+    ~EpochManager()
+    {
+        drain();
+    }
+};
+
+#endif
@@ -1,4 +1,14 @@
+#ifndef HASHTABLE_CPP
+#define HASHTABLE_CPP
+
 #include <iostream>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 
 using namespace std;
 
@@ -478,6 +488,23 @@ class Linkedlist {
         return false;
     }
 
+    /**
+     * removeFirst - remove the first element from the linked list
+     * @data: set to the removed element
+     * return: true if an element is removed
+     *         false if the list is empty
+     */
+    bool removeFirst(int &data){
+        if(head == NULL){
+            return false;
+        }
+        Node *temp = head;
+        data = temp->data;
+        head = temp->next;
+        delete temp;
+        return true;
+    }
+
     /**
      * removeall - remove all the elements from the linked list
      * return: void
@@ -520,6 +547,7 @@ class HashTableChaining {
     Linkedlist *table;
     int size;
     int capacity;
+    int resizeCount;
 
 
     int hashingfunction(int key){
@@ -536,6 +564,7 @@ class HashTableChaining {
         this->capacity = capacity;
         table = new Linkedlist[capacity];
         this->size = 0;
+        this->resizeCount = 0;
 
     }
 
@@ -565,14 +594,33 @@ class HashTableChaining {
         Linkedlist *oldtable = this->table;
         this->capacity = 2 * this->capacity;
         this->table = new Linkedlist[this->capacity];
-        this->size = 0;
         for(int i = 0; i < oldcapacity; i++){
-            oldtable[i].removeall();
+            int key;
+            while(oldtable[i].removeFirst(key)){
+                table[hashingfunction(key)].insert(key);
+            }
         }
         delete[] oldtable;
+        this->resizeCount++;
         return;
     }
 
+    /**
+     * getResizeCount - number of times the table has been rehashed
+     * return: resize count
+     */
+    int getResizeCount(){
+        return resizeCount;
+    }
+
+    /**
+     * getCapacity - current capacity of the hash table
+     * return: capacity
+     */
+    int getCapacity(){
+        return capacity;
+    }
+
     /**
      * searchElement - search an element in the hash table
      * @key: key to be searched
@@ -631,6 +679,7 @@ class HashTableOpenAddressing {
 
     int size;
     int capacity;
+    int resizeCount;
 
     /**
      * hashingfunction - function to calculate the hash value
@@ -644,6 +693,7 @@ class HashTableOpenAddressing {
     public:
     HashTableOpenAddressing(int capacity){
         this->capacity = capacity;
+        this->resizeCount = 0;
         table = new int[capacity];
         flag = new int[capacity];
         for(int i = 0; i < capacity; i++){
@@ -683,7 +733,8 @@ class HashTableOpenAddressing {
             int *oldflag = this->flag;
             this->capacity = 2 * this->capacity;
             this->table = new int[this->capacity];
-            this->flag = new int[this->capacity];
+            this->flag = new int[this->capacity]();
+            this->resizeCount++;
             for(int i = 0; i < oldcapacity; i++){
                 if(oldflag[i] == 1){
                     insertElement(oldtable[i]);
@@ -695,6 +746,22 @@ class HashTableOpenAddressing {
                 
         }
     }
+    /**
+     * getResizeCount - number of times the table has been extended
+     * return: resize count
+     */
+    int getResizeCount(){
+        return resizeCount;
+    }
+
+    /**
+     * getCapacity - current capacity of the hash table
+     * return: capacity
+     */
+    int getCapacity(){
+        return capacity;
+    }
+
     /**
      * searchElement - search an element in the hash table
      * @key: key to be searched
@@ -771,6 +838,7 @@ class HashTableDoubleHashing {
     int *flag;
     int size;
     int capacity;
+    int resizeCount;
     /**
      * hashingfunction - function to calculate the hash value
      * @key: key to be hashed
@@ -796,6 +864,7 @@ class HashTableDoubleHashing {
      */
     HashTableDoubleHashing(int capacity){
         this->capacity = capacity;
+        this->resizeCount = 0;
         table = new int[capacity];
         flag = new int[capacity];
         for(int i = 0; i < capacity; i++){
@@ -834,7 +903,8 @@ class HashTableDoubleHashing {
             int *oldflag = this->flag;
             this->capacity = 2 * this->capacity;
             this->table = new int[this->capacity];
-            this->flag = new int[this->capacity];
+            this->flag = new int[this->capacity]();
+            this->resizeCount++;
             for(int i = 0; i < oldcapacity; i++){
                 if(oldflag[i] == 1){
                     insertElement(oldtable[i]);
@@ -846,6 +916,22 @@ class HashTableDoubleHashing {
         }
     }
 
+    /**
+     * getResizeCount - number of times the table has been extended
+     * return: resize count
+     */
+    int getResizeCount(){
+        return resizeCount;
+    }
+
+    /**
+     * getCapacity - current capacity of the hash table
+     * return: capacity
+     */
+    int getCapacity(){
+        return capacity;
+    }
+
     /**
      * searchElement - search an element in the hash table
      * @key: key to be searched
@@ -905,6 +991,450 @@ class HashTableDoubleHashing {
     }
 };
 
+/* String keys */
+
+static const uint64_t hashSecret[4] = {
+    0xa0761d6478bd642full, 0xe7037ed1a0b428dbull,
+    0x8ebc6af09c88c6e3ull, 0x589965cc75374cc3ull
+};
+static const uint64_t hashStripeKey[8] = {
+    0xbe4ba423396cfeb8ull, 0x1cad21f72c81017cull, 0xdb979083e96dd4deull, 0x1f67b3b7a4a44072ull,
+    0x78e5c0cc4ee679cbull, 0x2172ffcc7dd05a82ull, 0x8e2443f7744608b8ull, 0x4c263a81e69035e0ull
+};
+static const uint64_t hashPrime32 = 0x9e3779b1ull;
+static const size_t hashStripeBytes = 64;
+static const size_t hashStripesPerBlock = 16;
+static const size_t hashLongKey = 256;
+
+/**
+ * hashMum - multiply two 64 bit words and fold the 128 bit product
+ * return: folded product
+ */
+static inline uint64_t hashMum(uint64_t a, uint64_t b){
+    __uint128_t product = (__uint128_t)a * b;
+    return (uint64_t)product ^ (uint64_t)(product >> 64);
+}
+
+static inline uint64_t hashRead64(const unsigned char *p){
+    uint64_t value;
+    memcpy(&value, p, 8);
+    return value;
+}
+
+static inline uint64_t hashRead32(const unsigned char *p){
+    uint32_t value;
+    memcpy(&value, p, 4);
+    return value;
+}
+
+/**
+ * hashShort - wyhash style hash for keys that are not handled by stripes
+ * @p: key bytes
+ * @length: number of bytes
+ * @seed: seed already mixed with the secret
+ * return: 64 bit hash
+ */
+static inline uint64_t hashShort(const unsigned char *p, size_t length, uint64_t seed){
+    uint64_t a;
+    uint64_t b;
+    if(length <= 16){
+        if(length >= 4){
+            size_t middle = (length >> 3) << 2;
+            a = (hashRead32(p) << 32) | hashRead32(p + middle);
+            b = (hashRead32(p + length - 4) << 32) | hashRead32(p + length - 4 - middle);
+        }
+        else if(length > 0){
+            a = ((uint64_t)p[0] << 16) | ((uint64_t)p[length >> 1] << 8) | p[length - 1];
+            b = 0;
+        }
+        else {
+            a = 0;
+            b = 0;
+        }
+    }
+    else {
+        size_t i = length;
+        if(i > 48){
+            uint64_t see1 = seed;
+            uint64_t see2 = seed;
+            do {
+                seed = hashMum(hashRead64(p) ^ hashSecret[1], hashRead64(p + 8) ^ seed);
+                see1 = hashMum(hashRead64(p + 16) ^ hashSecret[2], hashRead64(p + 24) ^ see1);
+                see2 = hashMum(hashRead64(p + 32) ^ hashSecret[3], hashRead64(p + 40) ^ see2);
+                p += 48;
+                i -= 48;
+            } while(i > 48);
+            seed ^= see1 ^ see2;
+        }
+        while(i > 16){
+            seed = hashMum(hashRead64(p) ^ hashSecret[1], hashRead64(p + 8) ^ seed);
+            i -= 16;
+            p += 16;
+        }
+        a = hashRead64(p + i - 16);
+        b = hashRead64(p + i - 8);
+    }
+    return hashMum(hashSecret[1] ^ length, hashMum(a ^ hashSecret[1], b ^ seed));
+}
+
+/**
+ * hashStripesScalar - accumulate 64 byte stripes into 8 lanes
+ * @acc: lane accumulators
+ * @p: first stripe
+ * @stripes: number of stripes to consume
+ *
+ * Every lane adds the product of the low and high halves of the keyed
+ * input word and the neighbouring input word, like XXH3.
+ */
+static inline void hashStripesScalar(uint64_t acc[8], const unsigned char *p, size_t stripes){
+    for(size_t s = 0; s < stripes; s++, p += hashStripeBytes){
+        for(int lane = 0; lane < 8; lane++){
+            uint64_t data = hashRead64(p + 8 * lane);
+            uint64_t keyed = data ^ hashStripeKey[lane];
+            acc[lane ^ 1] += data;
+            acc[lane] += (keyed & 0xffffffffull) * (keyed >> 32);
+        }
+    }
+}
+
+static inline void hashScrambleScalar(uint64_t acc[8]){
+    for(int lane = 0; lane < 8; lane++){
+        acc[lane] ^= acc[lane] >> 47;
+        acc[lane] ^= hashStripeKey[7 - lane];
+        acc[lane] *= hashPrime32;
+    }
+}
+
+#if defined(__SSE2__)
+/**
+ * hashStripesSse2 - SSE2 version of hashStripesScalar, two lanes per register
+ */
+static inline void hashStripesSse2(uint64_t acc[8], const unsigned char *p, size_t stripes){
+    __m128i lanes[4];
+    __m128i keys[4];
+    for(int i = 0; i < 4; i++){
+        lanes[i] = _mm_loadu_si128((const __m128i *)(acc + 2 * i));
+        keys[i] = _mm_loadu_si128((const __m128i *)(hashStripeKey + 2 * i));
+    }
+    for(size_t s = 0; s < stripes; s++, p += hashStripeBytes){
+        for(int i = 0; i < 4; i++){
+            __m128i data = _mm_loadu_si128((const __m128i *)(p + 16 * i));
+            __m128i keyed = _mm_xor_si128(data, keys[i]);
+            __m128i high = _mm_shuffle_epi32(keyed, _MM_SHUFFLE(3, 3, 1, 1));
+            __m128i product = _mm_mul_epu32(keyed, high);
+            __m128i swapped = _mm_shuffle_epi32(data, _MM_SHUFFLE(1, 0, 3, 2));
+            lanes[i] = _mm_add_epi64(lanes[i], _mm_add_epi64(product, swapped));
+        }
+    }
+    for(int i = 0; i < 4; i++){
+        _mm_storeu_si128((__m128i *)(acc + 2 * i), lanes[i]);
+    }
+}
+
+static inline void hashScrambleSse2(uint64_t acc[8]){
+    const __m128i prime = _mm_set1_epi32((int)hashPrime32);
+    for(int i = 0; i < 4; i++){
+        __m128i lane = _mm_loadu_si128((const __m128i *)(acc + 2 * i));
+        __m128i key = _mm_set_epi64x((long long)hashStripeKey[6 - 2 * i], (long long)hashStripeKey[7 - 2 * i]);
+        lane = _mm_xor_si128(lane, _mm_srli_epi64(lane, 47));
+        lane = _mm_xor_si128(lane, key);
+        __m128i low = _mm_mul_epu32(lane, prime);
+        __m128i high = _mm_mul_epu32(_mm_srli_epi64(lane, 32), prime);
+        lane = _mm_add_epi64(low, _mm_slli_epi64(high, 32));
+        _mm_storeu_si128((__m128i *)(acc + 2 * i), lane);
+    }
+}
+#endif
+
+/**
+ * hashLong - stripe accumulation for keys of hashLongKey bytes or more
+ * @p: key bytes
+ * @length: number of bytes
+ * @seed: seed already mixed with the secret
+ * @simd: use the SSE2 kernels when they are compiled in
+ * return: 64 bit hash
+ */
+static inline uint64_t hashLong(const unsigned char *p, size_t length, uint64_t seed, bool simd){
+    uint64_t acc[8];
+    for(int lane = 0; lane < 8; lane++){
+        acc[lane] = hashStripeKey[lane] ^ seed;
+    }
+    size_t stripes = length / hashStripeBytes;
+    const unsigned char *stripe = p;
+    while(stripes > 0){
+        size_t count = stripes < hashStripesPerBlock ? stripes : hashStripesPerBlock;
+#if defined(__SSE2__)
+        if(simd){
+            hashStripesSse2(acc, stripe, count);
+            if(count == hashStripesPerBlock){
+                hashScrambleSse2(acc);
+            }
+        }
+        else
+#endif
+        {
+            hashStripesScalar(acc, stripe, count);
+            if(count == hashStripesPerBlock){
+                hashScrambleScalar(acc);
+            }
+        }
+        stripe += count * hashStripeBytes;
+        stripes -= count;
+    }
+    // the last bytes go through the short path, always at least 17 of them
+    size_t tail = length - (stripe - p);
+    if(tail <= 16){
+        tail += hashStripeBytes;
+    }
+    uint64_t result = hashShort(p + length - tail, tail, seed);
+    result ^= length * hashSecret[0];
+    for(int lane = 0; lane < 8; lane += 2){
+        result = hashMum(acc[lane] ^ hashSecret[1], acc[lane + 1] ^ result);
+    }
+    return result;
+}
+
+/**
+ * hashBytes - 64 bit hash of a byte span
+ * @data: first byte
+ * @length: number of bytes
+ * @seed: optional seed
+ * return: 64 bit hash
+ *
+ * Keys shorter than hashLongKey bytes use wyhash style multiply-fold
+ * rounds, longer keys are folded 64 bytes at a time with SSE2 when the
+ * target has it.
+ */
+static inline uint64_t hashBytes(const void *data, size_t length, uint64_t seed = 0){
+    const unsigned char *p = (const unsigned char *)data;
+    seed ^= hashMum(seed ^ hashSecret[0], hashSecret[1]);
+    if(length >= hashLongKey){
+        return hashLong(p, length, seed, true);
+    }
+    return hashShort(p, length, seed);
+}
+
+/**
+ * hashBytesScalar - hashBytes without the SIMD kernels
+ * gives the same value as hashBytes on every target
+ */
+static inline uint64_t hashBytesScalar(const void *data, size_t length, uint64_t seed = 0){
+    const unsigned char *p = (const unsigned char *)data;
+    seed ^= hashMum(seed ^ hashSecret[0], hashSecret[1]);
+    if(length >= hashLongKey){
+        return hashLong(p, length, seed, false);
+    }
+    return hashShort(p, length, seed);
+}
+
+static inline uint64_t hashString(string_view key){
+    return hashBytes(key.data(), key.size());
+}
 
+/**
+ * HashTableString - open addressing hash table from string keys to int values
+ * @table: array to store the keys
+ * @values: array to store the values
+ * @hashes: array to store the full hash of every key
+ * @flag: array to store the status of the slots (0 empty, 1 used, 2 deleted)
+ * @size: number of elements in the hash table
+ * @used: number of slots that are used or deleted
+ * @capacity: capacity of the hash table, always a power of two
+ *
+ * Keys are compared only when the stored hash matches, so a probe
+ * almost never touches the string bytes of a different key.
+ */
+class HashTableString {
+    private:
+    string *table;
+    int *values;
+    uint64_t *hashes;
+    int *flag;
+
+    int size;
+    int used;
+    int capacity;
+    int resizeCount;
+
+    int hashingfunction(uint64_t hash){
+        return (int)(hash & (uint64_t)(capacity - 1));
+    }
+
+    /**
+     * findSlot - probe for a key
+     * @key: key to be searched
+     * @hash: hash of the key
+     * return: index of the key
+     *         -1 if the key is not found
+     */
+    int findSlot(string_view key, uint64_t hash){
+        int index = hashingfunction(hash);
+        for(int i = 0; i < capacity; i++){
+            if(flag[index] == 0){
+                return -1;
+            }
+            if(flag[index] == 1 && hashes[index] == hash && table[index] == key){
+                return index;
+            }
+            index = (index + 1) & (capacity - 1);
+        }
+        return -1;
+    }
+
+    void allocate(int capacity){
+        this->capacity = capacity;
+        table = new string[capacity];
+        values = new int[capacity];
+        hashes = new uint64_t[capacity];
+        flag = new int[capacity]();
+        this->size = 0;
+        this->used = 0;
+    }
+
+    void release(){
+        delete[] table;
+        delete[] values;
+        delete[] hashes;
+        delete[] flag;
+    }
+
+    /**
+     * rehash - move every key into a table of the given capacity
+     * the stored hashes are reused, no key is hashed again
+     * return void
+     */
+    void rehash(int newCapacity){
+        int oldcapacity = this->capacity;
+        string *oldtable = this->table;
+        int *oldvalues = this->values;
+        uint64_t *oldhashes = this->hashes;
+        int *oldflag = this->flag;
+        allocate(newCapacity);
+        for(int i = 0; i < oldcapacity; i++){
+            if(oldflag[i] == 1){
+                int index = hashingfunction(oldhashes[i]);
+                while(flag[index] != 0){
+                    index = (index + 1) & (capacity - 1);
+                }
+                table[index] = std::move(oldtable[i]);
+                values[index] = oldvalues[i];
+                hashes[index] = oldhashes[i];
+                flag[index] = 1;
+                this->size++;
+                this->used++;
+            }
+        }
+        delete[] oldtable;
+        delete[] oldvalues;
+        delete[] oldhashes;
+        delete[] oldflag;
+        this->resizeCount++;
+    }
+
+    public:
+    /**
+     * HashTableString - constructor
+     * @capacity: initial capacity, rounded up to a power of two
+     * return: HashTableString object
+     */
+    HashTableString(int capacity){
+        int rounded = 8;
+        while(rounded < capacity){
+            rounded *= 2;
+        }
+        allocate(rounded);
+        this->resizeCount = 0;
+    }
+
+    HashTableString(const HashTableString &) = delete;
+    HashTableString &operator=(const HashTableString &) = delete;
+
+    /**
+     * insertElement - insert a key and its value into the hash table
+     * @key: key to be inserted
+     * @value: value stored with the key
+     * return: index where the key is inserted
+     *         -1 if the key already exists
+     */
+    int insertElement(string_view key, int value){
+        uint64_t hash = hashString(key);
+        if(findSlot(key, hash) != -1){
+            return -1;
+        }
+        if((this->used + 1) * 4 > this->capacity * 3){
+            // only grow when live keys fill the table, otherwise drop the deleted slots
+            rehash(this->size * 2 >= this->capacity ? 2 * this->capacity : this->capacity);
+        }
+        int index = hashingfunction(hash);
+        while(flag[index] == 1){
+            index = (index + 1) & (capacity - 1);
+        }
+        if(flag[index] == 0){
+            this->used++;
+        }
+        table[index] = string(key);
+        values[index] = value;
+        hashes[index] = hash;
+        flag[index] = 1;
+        this->size++;
+        return index;
+    }
 
+    /**
+     * searchElement - search a key in the hash table
+     * @key: key to be searched
+     * return: index where the key is found
+     *         -1 if the key is not found
+     */
+    int searchElement(string_view key){
+        return findSlot(key, hashString(key));
+    }
+
+    /**
+     * getValue - value stored at an index returned by searchElement
+     * @index: index of the key
+     * return: stored value
+     */
+    int getValue(int index){
+        return values[index];
+    }
+
+    /**
+     * deleteElement - delete a key from the hash table
+     * @key: key to be deleted
+     * return: index where the key is deleted
+     *         -1 if the key is not found
+     */
+    int deleteElement(string_view key){
+        int index = findSlot(key, hashString(key));
+        if(index == -1){
+            return -1;
+        }
+        flag[index] = 2;
+        table[index].clear();
+        this->size--;
+        return index;
+    }
+
+    int getSize(){
+        return size;
+    }
+
+    int getResizeCount(){
+        return resizeCount;
+    }
+
+    int getCapacity(){
+        return capacity;
+    }
+
+    /**
+     * ~HashTableString - destructor
+     * delete the slot arrays
+     */
+    ~HashTableString(){
+        release();
+    }
+};
 
+#endif
@@ -96,6 +96,46 @@ void testHashTableDoubleHashing() {
     assert(ht.searchElement(5) == -1);
 }
 
+void testHashBytes() {
+    string key(1000, 'a');
+    for (int i = 0; i < (int)key.size(); i++) {
+        key[i] = (char)(i * 31 + 7);
+    }
+    for (int length = 0; length <= (int)key.size(); length++) {
+        assert(hashBytes(key.data(), length) == hashBytesScalar(key.data(), length));
+        assert(hashBytes(key.data(), length, 99) == hashBytesScalar(key.data(), length, 99));
+    }
+    assert(hashBytes(key.data(), 300) != hashBytes(key.data(), 301));
+    assert(hashBytes(key.data(), 300) != hashBytes(key.data(), 300, 1));
+    string other = key;
+    other[150] ^= 1;
+    assert(hashBytes(key.data(), 300) != hashBytes(other.data(), 300));
+    assert(hashString("player1") != hashString("player2"));
+}
+
+void testHashTableString() {
+    HashTableString ht(4);
+    assert(ht.insertElement("alice", 10) != -1);
+    assert(ht.insertElement("alice", 11) == -1);
+    assert(ht.getValue(ht.searchElement("alice")) == 10);
+    for (int i = 0; i < 1000; i++) {
+        assert(ht.insertElement("player" + to_string(i), i) != -1);
+    }
+    assert(ht.getSize() == 1001);
+    assert(ht.getResizeCount() > 0);
+    for (int i = 0; i < 1000; i += 2) {
+        assert(ht.deleteElement("player" + to_string(i)) != -1);
+    }
+    for (int i = 0; i < 1000; i++) {
+        int index = ht.searchElement("player" + to_string(i));
+        assert((index == -1) == (i % 2 == 0));
+        assert(index == -1 || ht.getValue(index) == i);
+    }
+    assert(ht.deleteElement("alice") != -1);
+    assert(ht.searchElement("alice") == -1);
+    assert(ht.getSize() == 500);
+}
+
 int main() {
     testHashTableDivision();
     testHashTableMultiplication();
@@ -105,6 +145,8 @@ int main() {
     testHashTableChaining();
     testHashTableOpenAddressing();
     testHashTableDoubleHashing();
+    testHashBytes();
+    testHashTableString();
     std::cout << "All tests passed!" << std::endl;
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,43 @@
+#ifndef KEYSEARCH_CPP
+#define KEYSEARCH_CPP
+
+#include <algorithm>
+#include <type_traits>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+using namespace std;
+
+// How many of keys[0, count) are below value, or not above it when
+// OrEqual is set. For int keys this compares four keys per SSE2
+// instruction and stops at the first block that is not all below.
+template <bool OrEqual, class T>
+int countBelow(const T *keys, int count, const T &value)
+{
+#ifdef __SSE2__
+    if constexpr (is_same<T, int>::value)
+    {
+        __m128i probe = _mm_set1_epi32(value);
+        int below = 0;
+        int i = 0;
+        for (; i + 4 <= count; i += 4)
+        {
+            __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(keys + i));
+            int mask = OrEqual ? 0xF & ~_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpgt_epi32(block, probe)))
+                               : _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpgt_epi32(probe, block)));
+            below += __builtin_popcount(mask);
+            if (mask != 0xF)
+                return below;
+        }
+        for (; i < count && (OrEqual ? !(value < keys[i]) : keys[i] < value); i++)
+            below++;
+        return below;
+    }
+#endif
+    if constexpr (OrEqual)
+        return int(std::upper_bound(keys, keys + count, value) - keys);
+    else
+        return int(std::lower_bound(keys, keys + count, value) - keys);
+}
+
+#endif
@@ -0,0 +1,343 @@
+#ifndef LEFTLEANINGREDBLACKTREE_CPP
+#define LEFTLEANINGREDBLACKTREE_CPP
+
+#include <iostream>
+#include <type_traits>
+#include <utility>
+#include "NodeAllocator.cpp"
+using namespace std;
+
+// No parent link: rebalancing happens on the way back out of the
+// recursion, which already holds the path.
+template <class T>
+struct LeftLeaningNode
+{
+    T value;
+    LeftLeaningNode *left = nullptr;
+    LeftLeaningNode *right = nullptr;
+    bool isRed = true;
+};
+
+// Sedgewick's left-leaning red-black tree: a red link always leans left,
+// which leaves only two rotation cases per level. Same Insert/Delete API
+// as RedBlackTree, one pointer less per node.
+template <class T, template <class> class Allocator = SlabAllocator>
+class LeftLeaningRedBlackTree
+{
+    typedef LeftLeaningNode<T> NodeType;
+
+    NodeType *root = nullptr;
+    Allocator<NodeType> allocator;
+    size_t nodeCount = 0;
+
+    NodeType *createNode(T value)
+    {
+        return new (allocator.allocate()) NodeType{std::move(value)};
+    }
+
+    void destroyNode(NodeType *node)
+    {
+        node->~NodeType();
+        allocator.deallocate(node);
+    }
+
+    void destroySubtree(NodeType *node)
+    {
+        while (node != nullptr)
+        {
+            destroySubtree(node->left);
+            NodeType *right = node->right;
+            destroyNode(node);
+            node = right;
+        }
+    }
+
+    void destroyAll()
+    {
+        if (!Allocator<NodeType>::bulkRelease || !is_trivially_destructible<T>::value)
+            destroySubtree(root);
+        allocator.release();
+        root = nullptr;
+        nodeCount = 0;
+    }
+
+    static bool isRedNode(const NodeType *node)
+    {
+        return node != nullptr && node->isRed;
+    }
+
+    static NodeType *rotateLeft(NodeType *node)
+    {
+        NodeType *newParent = node->right;
+        node->right = newParent->left;
+        newParent->left = node;
+        newParent->isRed = node->isRed;
+        node->isRed = true;
+        return newParent;
+    }
+
+    static NodeType *rotateRight(NodeType *node)
+    {
+        NodeType *newParent = node->left;
+        node->left = newParent->right;
+        newParent->right = node;
+        newParent->isRed = node->isRed;
+        node->isRed = true;
+        return newParent;
+    }
+
+    static void flipColors(NodeType *node)
+    {
+        node->isRed = !node->isRed;
+        node->left->isRed = !node->left->isRed;
+        node->right->isRed = !node->right->isRed;
+    }
+
+    static NodeType *balance(NodeType *node)
+    {
+        if (isRedNode(node->right) && !isRedNode(node->left))
+            node = rotateLeft(node);
+        if (isRedNode(node->left) && isRedNode(node->left->left))
+            node = rotateRight(node);
+        if (isRedNode(node->left) && isRedNode(node->right))
+            flipColors(node);
+        return node;
+    }
+
+    // Borrow from the sibling so the next node down the left is not a
+    // lone black node.
+    static NodeType *moveRedLeft(NodeType *node)
+    {
+        flipColors(node);
+        if (isRedNode(node->right->left))
+        {
+            node->right = rotateRight(node->right);
+            node = rotateLeft(node);
+            flipColors(node);
+        }
+        return node;
+    }
+
+    static NodeType *moveRedRight(NodeType *node)
+    {
+        flipColors(node);
+        if (isRedNode(node->left->left))
+        {
+            node = rotateRight(node);
+            flipColors(node);
+        }
+        return node;
+    }
+
+    NodeType *insert(NodeType *node, NodeType *newNode)
+    {
+        if (node == nullptr)
+            return newNode;
+        if (newNode->value < node->value)
+            node->left = insert(node->left, newNode);
+        else
+            node->right = insert(node->right, newNode);
+        return balance(node);
+    }
+
+    // Unlinks the smallest node under node and hands it back in minimum.
+    NodeType *removeMinimum(NodeType *node, NodeType *&minimum)
+    {
+        if (node->left == nullptr)
+        {
+            minimum = node;
+            return nullptr;
+        }
+        if (!isRedNode(node->left) && !isRedNode(node->left->left))
+            node = moveRedLeft(node);
+        node->left = removeMinimum(node->left, minimum);
+        return balance(node);
+    }
+
+    // value must be in the subtree.
+    NodeType *remove(NodeType *node, const T &value)
+    {
+        if (value < node->value)
+        {
+            if (!isRedNode(node->left) && !isRedNode(node->left->left))
+                node = moveRedLeft(node);
+            node->left = remove(node->left, value);
+        }
+        else
+        {
+            if (isRedNode(node->left))
+                node = rotateRight(node);
+            if (!(node->value < value) && node->right == nullptr)
+            {
+                destroyNode(node);
+                return nullptr;
+            }
+            // When moveRedRight rotates, node moves down to the right. An
+            // equal key rotated up from the left cannot be removed here,
+            // its right child is black, so follow node instead.
+            NodeType *matched = node;
+            if (!isRedNode(node->right) && !isRedNode(node->right->left))
+                node = moveRedRight(node);
+            if (node == matched && !(node->value < value))
+            {
+                // The successor takes the place of node in the tree.
+                NodeType *successor;
+                NodeType *right = removeMinimum(node->right, successor);
+                successor->left = node->left;
+                successor->right = right;
+                successor->isRed = node->isRed;
+                destroyNode(node);
+                node = successor;
+            }
+            else
+                node->right = remove(node->right, value);
+        }
+        return balance(node);
+    }
+
+    const NodeType *findNode(const T &value) const
+    {
+        const NodeType *current = root;
+        while (current != nullptr)
+        {
+            if (value < current->value)
+                current = current->left;
+            else if (current->value < value)
+                current = current->right;
+            else
+                return current;
+        }
+        return nullptr;
+    }
+
+    // Black height of the subtree, or -1 if it breaks an invariant.
+    static int validateSubtree(const NodeType *node, const T *&previous, size_t &count)
+    {
+        if (node == nullptr)
+            return 1;
+        count++;
+        if (isRedNode(node->right))
+            return -1;
+        if (node->isRed && isRedNode(node->left))
+            return -1;
+        int leftHeight = validateSubtree(node->left, previous, count);
+        if (leftHeight < 0 || (previous != nullptr && node->value < *previous))
+            return -1;
+        previous = &node->value;
+        int rightHeight = validateSubtree(node->right, previous, count);
+        if (rightHeight != leftHeight)
+            return -1;
+        return leftHeight + (node->isRed ? 0 : 1);
+    }
+
+    void print(const NodeType *node, int depth) const
+    {
+        if (node != nullptr)
+        {
+            for (int i = 0; i < depth; i++)
+                cout << "  ";
+
+            cout << node->value << (node->isRed ? "(r)\n" : "(b)\n");
+
+            print(node->left, depth + 1);
+            print(node->right, depth + 1);
+        }
+    }
+
+public:
+    LeftLeaningRedBlackTree() {}
+    LeftLeaningRedBlackTree(const LeftLeaningRedBlackTree &) = delete;
+    LeftLeaningRedBlackTree &operator=(const LeftLeaningRedBlackTree &) = delete;
+
+    ~LeftLeaningRedBlackTree()
+    {
+        destroyAll();
+    }
+
+    void clear()
+    {
+        destroyAll();
+    }
+
+    size_t size() const
+    {
+        return nodeCount;
+    }
+
+    bool empty() const
+    {
+        return root == nullptr;
+    }
+
+    void Insert(T value)
+    {
+        root = insert(root, createNode(std::move(value)));
+        root->isRed = false;
+        nodeCount++;
+    }
+
+    void Delete(T value)
+    {
+        if (findNode(value) == nullptr)
+        {
+            cout << "not found\n";
+            return;
+        }
+
+        if (!isRedNode(root->left) && !isRedNode(root->right))
+            root->isRed = true;
+        root = remove(root, value);
+        if (root != nullptr)
+            root->isRed = false;
+        nodeCount--;
+    }
+
+    const T *find(const T &value) const
+    {
+        const NodeType *node = findNode(value);
+        return node == nullptr ? nullptr : &node->value;
+    }
+
+    bool contains(const T &value) const
+    {
+        return findNode(value) != nullptr;
+    }
+
+    // Checks order, that red links lean left and never come two in a row,
+    // black heights and the cached size. For tests, O(n).
+    bool validate() const
+    {
+        if (isRedNode(root))
+            return false;
+        const T *previous = nullptr;
+        size_t count = 0;
+        return validateSubtree(root, previous, count) >= 0 && count == nodeCount;
+    }
+
+    void print() const
+    {
+        print(root, 0);
+    }
+};
+
+#ifndef NO_MAIN
+int main()
+{
+    LeftLeaningRedBlackTree<int> tree;
+    tree.Insert(200);
+    tree.Insert(158);
+    tree.Insert(2500);
+    tree.Insert(555);
+    tree.Insert(0);
+    tree.print();
+
+    tree.Delete(50);
+    tree.Delete(200);
+    tree.print();
+
+    cout << "bytes per node: " << sizeof(LeftLeaningNode<int>) << endl;
+    return 0;
+}
+#endif
+
+#endif
@@ -0,0 +1,83 @@
+#define NO_MAIN
+#include <iostream>
+#include <cassert>
+#include <random>
+#include <set>
+#include "LeftLeaningRedBlackTree.cpp"
+
+void testRandomInsertDelete() {
+    LeftLeaningRedBlackTree<int> tree;
+    multiset<int> reference;
+    mt19937 gen(1);
+    for (int i = 0; i < 20000; i++) {
+        int value = gen() % 500;
+        if (gen() % 3 != 0 || reference.empty()) {
+            tree.Insert(value);
+            reference.insert(value);
+        }
+        else {
+            int victim = *reference.lower_bound(value % (*reference.rbegin() + 1));
+            tree.Delete(victim);
+            reference.erase(reference.find(victim));
+        }
+        if (i % 500 == 0) {
+            assert(tree.validate());
+        }
+    }
+    assert(tree.validate());
+    assert(tree.size() == reference.size());
+    for (int value = 0; value < 500; value++) {
+        assert(tree.contains(value) == (reference.count(value) != 0));
+    }
+}
+
+// Every copy of a key has to be deleted before the key is gone.
+void testDuplicates() {
+    LeftLeaningRedBlackTree<int> tree;
+    multiset<int> reference;
+    for (int round = 0; round < 4; round++) {
+        for (int i = 0; i < 300; i++) {
+            tree.Insert(i % 37);
+            reference.insert(i % 37);
+        }
+    }
+    assert(tree.validate());
+    assert(tree.size() == 1200);
+    mt19937 gen(2);
+    while (!reference.empty()) {
+        auto victim = reference.begin();
+        advance(victim, gen() % reference.size());
+        int value = *victim;
+        reference.erase(victim);
+        tree.Delete(value);
+        assert(tree.contains(value) == (reference.count(value) != 0));
+        assert(tree.size() == reference.size());
+        if (reference.size() % 100 == 0) {
+            assert(tree.validate());
+        }
+    }
+    assert(tree.empty());
+}
+
+void testSequentialInsertDelete() {
+    LeftLeaningRedBlackTree<int> tree;
+    for (int i = 0; i < 10000; i++) {
+        tree.Insert(i);
+    }
+    assert(tree.validate());
+    for (int i = 9999; i >= 0; i -= 2) {
+        tree.Delete(i);
+    }
+    assert(tree.validate());
+    assert(tree.size() == 5000 && tree.contains(0) && !tree.contains(1));
+    tree.clear();
+    assert(tree.empty() && tree.validate());
+}
+
+int main() {
+    testRandomInsertDelete();
+    testDuplicates();
+    testSequentialInsertDelete();
+    std::cout << "All tests passed!" << std::endl;
+    return 0;
+}
@@ -0,0 +1,308 @@
+#ifndef NODEALLOCATOR_CPP
+#define NODEALLOCATOR_CPP
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <vector>
+using namespace std;
+
+// Hands out node storage from chunks that grow geometrically, freed nodes
+// are kept on a free list and reused. The chunks live in a reference
+// counted arena, so trees that exchange nodes through join, split or the
+// set operations can share() or adopt() each other's memory. An arena is
+// freed when the last allocator using it lets go in release().
+template <class NodeT>
+class SlabAllocator
+{
+    struct FreeSlot
+    {
+        FreeSlot *next;
+    };
+    struct Chunk
+    {
+        Chunk *next;
+        NodeT *slots;
+    };
+    struct Arena
+    {
+        Chunk *chunks = nullptr;
+
+        NodeT *addChunk(size_t count)
+        {
+            Chunk *chunk = new Chunk;
+            chunk->slots = static_cast<NodeT *>(::operator new(count * sizeof(NodeT)));
+            chunk->next = chunks;
+            chunks = chunk;
+            return chunk->slots;
+        }
+
+        ~Arena()
+        {
+            while (chunks != nullptr)
+            {
+                Chunk *next = chunks->next;
+                ::operator delete(chunks->slots);
+                delete chunks;
+                chunks = next;
+            }
+        }
+    };
+
+    static const size_t FirstChunkSize = 32;
+    static const size_t MaxChunkSize = 4096;
+
+    shared_ptr<Arena> arena;
+    vector<shared_ptr<Arena>> borrowed;
+    FreeSlot *freeList = nullptr;
+    NodeT *bump = nullptr;
+    NodeT *bumpEnd = nullptr;
+    size_t nextChunkSize = FirstChunkSize;
+
+    Arena &ownArena()
+    {
+        if (!arena)
+            arena = make_shared<Arena>();
+        return *arena;
+    }
+
+    // Arenas are held once, so trees that keep exchanging nodes do not grow
+    // borrowed on every call.
+    void borrow(const shared_ptr<Arena> &other)
+    {
+        if (!other || other == arena)
+            return;
+        for (const shared_ptr<Arena> &held : borrowed)
+            if (held == other)
+                return;
+        borrowed.push_back(other);
+    }
+
+public:
+    static const bool bulkRelease = true;
+
+    SlabAllocator() {}
+    SlabAllocator(const SlabAllocator &) = delete;
+    SlabAllocator &operator=(const SlabAllocator &) = delete;
+
+    NodeT *allocate()
+    {
+        static_assert(sizeof(NodeT) >= sizeof(FreeSlot), "node too small for the free list");
+        if (freeList != nullptr)
+        {
+            FreeSlot *slot = freeList;
+            freeList = slot->next;
+            return reinterpret_cast<NodeT *>(slot);
+        }
+        if (bump == bumpEnd)
+        {
+            bump = ownArena().addChunk(nextChunkSize);
+            bumpEnd = bump + nextChunkSize;
+            if (nextChunkSize < MaxChunkSize)
+                nextChunkSize *= 2;
+        }
+        return bump++;
+    }
+
+    // A dedicated chunk of exactly count contiguous nodes.
+    NodeT *allocateBlock(size_t count)
+    {
+        return ownArena().addChunk(count);
+    }
+
+    void deallocate(NodeT *node)
+    {
+        FreeSlot *slot = reinterpret_cast<FreeSlot *>(node);
+        slot->next = freeList;
+        freeList = slot;
+    }
+
+    // Keeps the memory of other alive as long as this allocator, for nodes
+    // that moved from other's tree into ours.
+    void share(const SlabAllocator &other)
+    {
+        borrow(other.arena);
+        for (const shared_ptr<Arena> &held : other.borrowed)
+            borrow(held);
+    }
+
+    // Takes over all memory and free nodes of other, which ends up empty.
+    void adopt(SlabAllocator &other)
+    {
+        if (&other == this)
+            return;
+        share(other);
+        while (other.freeList != nullptr)
+        {
+            FreeSlot *slot = other.freeList;
+            other.freeList = slot->next;
+            deallocate(reinterpret_cast<NodeT *>(slot));
+        }
+        other.release();
+    }
+
+    void release()
+    {
+        arena.reset();
+        borrowed.clear();
+        freeList = nullptr;
+        bump = bumpEnd = nullptr;
+        nextChunkSize = FirstChunkSize;
+    }
+
+    ~SlabAllocator()
+    {
+        release();
+    }
+};
+
+// One heap allocation per node, the behaviour of plain new/delete.
+template <class NodeT>
+class HeapAllocator
+{
+public:
+    static const bool bulkRelease = false;
+
+    NodeT *allocate()
+    {
+        return static_cast<NodeT *>(::operator new(sizeof(NodeT)));
+    }
+
+    // Nodes are freed one by one, so there are no blocks.
+    NodeT *allocateBlock(size_t)
+    {
+        return nullptr;
+    }
+
+    void deallocate(NodeT *node)
+    {
+        ::operator delete(node);
+    }
+
+    void share(const HeapAllocator &) {}
+    void adopt(HeapAllocator &) {}
+    void release() {}
+};
+
+// Blocks of varying size, such as skip list nodes that carry their
+// forward pointers inline. Sizes are rounded up to a multiple of Step
+// (Alignment, but at least a pointer) and every size class keeps its own
+// free list; all classes are carved from the same chunks. As in
+// SlabAllocator the chunks live in a reference counted arena, so lists
+// that move nodes between each other can share() their memory.
+template <size_t Alignment = alignof(max_align_t)>
+class SizeClassAllocator
+{
+    static_assert(Alignment <= alignof(max_align_t), "chunks are only aligned for max_align_t");
+
+    struct FreeSlot
+    {
+        FreeSlot *next;
+    };
+
+    static const size_t Step = Alignment > sizeof(FreeSlot) ? Alignment : sizeof(FreeSlot);
+
+    struct Arena
+    {
+        vector<char *> chunks;
+
+        char *addChunk(size_t size)
+        {
+            chunks.push_back(static_cast<char *>(::operator new(size)));
+            return chunks.back();
+        }
+
+        ~Arena()
+        {
+            for (char *chunk : chunks)
+                ::operator delete(chunk);
+        }
+    };
+
+    static const size_t ChunkSize = 64 * 1024;
+
+    shared_ptr<Arena> arena;
+    vector<shared_ptr<Arena>> borrowed;
+    vector<FreeSlot *> freeLists;
+    char *bump = nullptr;
+    char *bumpEnd = nullptr;
+
+    static size_t sizeClass(size_t bytes)
+    {
+        return (bytes + Step - 1) / Step;
+    }
+
+    // Same as SlabAllocator::borrow.
+    void borrow(const shared_ptr<Arena> &other)
+    {
+        if (!other || other == arena)
+            return;
+        for (const shared_ptr<Arena> &held : borrowed)
+            if (held == other)
+                return;
+        borrowed.push_back(other);
+    }
+
+public:
+    SizeClassAllocator() {}
+    SizeClassAllocator(const SizeClassAllocator &) = delete;
+    SizeClassAllocator &operator=(const SizeClassAllocator &) = delete;
+
+    void *allocate(size_t bytes)
+    {
+        size_t index = sizeClass(bytes);
+        if (index < freeLists.size() && freeLists[index] != nullptr)
+        {
+            FreeSlot *slot = freeLists[index];
+            freeLists[index] = slot->next;
+            return slot;
+        }
+        size_t rounded = index * Step;
+        if ((size_t)(bumpEnd - bump) < rounded)
+        {
+            size_t chunkSize = rounded > ChunkSize ? rounded : ChunkSize;
+            if (!arena)
+                arena = make_shared<Arena>();
+            bump = arena->addChunk(chunkSize);
+            bumpEnd = bump + chunkSize;
+        }
+        void *block = bump;
+        bump += rounded;
+        return block;
+    }
+
+    // bytes must be the size the block was allocated with.
+    void deallocate(void *block, size_t bytes)
+    {
+        size_t index = sizeClass(bytes);
+        if (index >= freeLists.size())
+            freeLists.resize(index + 1, nullptr);
+        FreeSlot *slot = static_cast<FreeSlot *>(block);
+        slot->next = freeLists[index];
+        freeLists[index] = slot;
+    }
+
+    // Keeps the memory of other alive as long as this allocator, for blocks
+    // that moved from other's list into ours.
+    void share(const SizeClassAllocator &other)
+    {
+        borrow(other.arena);
+        for (const shared_ptr<Arena> &held : other.borrowed)
+            borrow(held);
+    }
+
+    void release()
+    {
+        arena.reset();
+        borrowed.clear();
+        freeLists.clear();
+        bump = bumpEnd = nullptr;
+    }
+
+    ~SizeClassAllocator()
+    {
+        release();
+    }
+};
+
+#endif
@@ -0,0 +1,311 @@
+#ifndef PERSISTENTREDBLACKTREE_CPP
+#define PERSISTENTREDBLACKTREE_CPP
+
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <utility>
+#include <vector>
+using namespace std;
+
+// Nodes never change once built. Versions share every subtree an update
+// did not touch and free them by reference count when the last version
+// holding them goes away.
+template <class T>
+struct PersistentNode
+{
+    typedef shared_ptr<const PersistentNode> Link;
+
+    T value;
+    Link left;
+    Link right;
+    bool isRed;
+};
+
+// Functional red-black set. Insert and Delete copy the O(log n) nodes on
+// the search path and return a new version; the tree they were called on
+// stays valid and unchanged, so copying a tree is an O(1) snapshot.
+// Rebalancing follows Okasaki for insert and Kahrs for delete.
+//
+// Versions may be read from several threads at once. The variable that
+// holds the current version still needs a lock (or atomic_load/store)
+// when one thread replaces it while others copy it.
+template <class T>
+class PersistentRedBlackTree
+{
+    typedef PersistentNode<T> NodeType;
+    typedef typename NodeType::Link Link;
+
+    Link root;
+    size_t count = 0;
+
+    PersistentRedBlackTree(Link root, size_t count) : root(std::move(root)), count(count) {}
+
+    static Link makeNode(bool isRed, Link left, const T &value, Link right)
+    {
+        return make_shared<const NodeType>(NodeType{value, std::move(left), std::move(right), isRed});
+    }
+
+    static bool isRedNode(const Link &node) { return node != nullptr && node->isRed; }
+    static bool isBlackNode(const Link &node) { return node != nullptr && !node->isRed; }
+
+    static Link blacken(const Link &node) { return makeNode(false, node->left, node->value, node->right); }
+    static Link redden(const Link &node) { return makeNode(true, node->left, node->value, node->right); }
+
+    // Black node over a and b, rewriting the four red-red shapes and the
+    // two red children case that delete leaves behind.
+    static Link balance(const Link &a, const T &value, const Link &b)
+    {
+        if (isRedNode(a) && isRedNode(b))
+            return makeNode(true, blacken(a), value, blacken(b));
+        if (isRedNode(a) && isRedNode(a->left))
+            return makeNode(true, blacken(a->left), a->value, makeNode(false, a->right, value, b));
+        if (isRedNode(a) && isRedNode(a->right))
+            return makeNode(true, makeNode(false, a->left, a->value, a->right->left), a->right->value,
+                            makeNode(false, a->right->right, value, b));
+        if (isRedNode(b) && isRedNode(b->right))
+            return makeNode(true, makeNode(false, a, value, b->left), b->value, blacken(b->right));
+        if (isRedNode(b) && isRedNode(b->left))
+            return makeNode(true, makeNode(false, a, value, b->left->left), b->left->value,
+                            makeNode(false, b->left->right, b->value, b->right));
+        return makeNode(false, a, value, b);
+    }
+
+    static Link insert(const Link &node, const T &value)
+    {
+        if (node == nullptr)
+            return makeNode(true, nullptr, value, nullptr);
+        if (value < node->value)
+        {
+            Link left = insert(node->left, value);
+            return node->isRed ? makeNode(true, left, node->value, node->right) : balance(left, node->value, node->right);
+        }
+        if (node->value < value)
+        {
+            Link right = insert(node->right, value);
+            return node->isRed ? makeNode(true, node->left, node->value, right) : balance(node->left, node->value, right);
+        }
+        return node;
+    }
+
+    // left lost one black level.
+    static Link balanceLeft(const Link &left, const T &value, const Link &right)
+    {
+        if (isRedNode(left))
+            return makeNode(true, blacken(left), value, right);
+        if (isBlackNode(right))
+            return balance(left, value, redden(right));
+        return makeNode(true, makeNode(false, left, value, right->left->left), right->left->value,
+                        balance(right->left->right, right->value, redden(right->right)));
+    }
+
+    // right lost one black level.
+    static Link balanceRight(const Link &left, const T &value, const Link &right)
+    {
+        if (isRedNode(right))
+            return makeNode(true, left, value, blacken(right));
+        if (isBlackNode(left))
+            return balance(redden(left), value, right);
+        return makeNode(true, balance(redden(left->left), left->value, left->right->left), left->right->value,
+                        makeNode(false, left->right->right, value, right));
+    }
+
+    // Joins the two children of a removed node, every key of left is
+    // smaller than every key of right.
+    static Link append(const Link &left, const Link &right)
+    {
+        if (left == nullptr)
+            return right;
+        if (right == nullptr)
+            return left;
+        if (left->isRed && right->isRed)
+        {
+            Link middle = append(left->right, right->left);
+            if (isRedNode(middle))
+                return makeNode(true, makeNode(true, left->left, left->value, middle->left), middle->value,
+                                makeNode(true, middle->right, right->value, right->right));
+            return makeNode(true, left->left, left->value, makeNode(true, middle, right->value, right->right));
+        }
+        if (!left->isRed && !right->isRed)
+        {
+            Link middle = append(left->right, right->left);
+            if (isRedNode(middle))
+                return makeNode(true, makeNode(false, left->left, left->value, middle->left), middle->value,
+                                makeNode(false, middle->right, right->value, right->right));
+            return balanceLeft(left->left, left->value, makeNode(false, middle, right->value, right->right));
+        }
+        if (right->isRed)
+            return makeNode(true, append(left, right->left), right->value, right->right);
+        return makeNode(true, left->left, left->value, append(left->right, right));
+    }
+
+    static Link remove(const Link &node, const T &value)
+    {
+        if (value < node->value)
+        {
+            if (isBlackNode(node->left))
+                return balanceLeft(remove(node->left, value), node->value, node->right);
+            return makeNode(true, remove(node->left, value), node->value, node->right);
+        }
+        if (node->value < value)
+        {
+            if (isBlackNode(node->right))
+                return balanceRight(node->left, node->value, remove(node->right, value));
+            return makeNode(true, node->left, node->value, remove(node->right, value));
+        }
+        return append(node->left, node->right);
+    }
+
+    const NodeType *findNode(const T &value) const
+    {
+        const NodeType *current = root.get();
+        while (current != nullptr)
+        {
+            if (value < current->value)
+                current = current->left.get();
+            else if (current->value < value)
+                current = current->right.get();
+            else
+                return current;
+        }
+        return nullptr;
+    }
+
+    void print(const NodeType *node, int depth) const
+    {
+        if (node != nullptr)
+        {
+            for (int i = 0; i < depth; i++)
+                cout << "  ";
+
+            cout << node->value << (node->isRed ? "(r)\n" : "(b)\n");
+
+            print(node->left.get(), depth + 1);
+            print(node->right.get(), depth + 1);
+        }
+    }
+
+public:
+    // In-order walk with an explicit stack, there are no parent links to
+    // follow. Valid while the version it came from is alive.
+    class iterator
+    {
+        vector<const NodeType *> path;
+
+        void pushLeft(const NodeType *node)
+        {
+            for (; node != nullptr; node = node->left.get())
+                path.push_back(node);
+        }
+
+    public:
+        typedef forward_iterator_tag iterator_category;
+        typedef T value_type;
+        typedef ptrdiff_t difference_type;
+        typedef const T *pointer;
+        typedef const T &reference;
+
+        iterator() {}
+        explicit iterator(const NodeType *root) { pushLeft(root); }
+
+        reference operator*() const { return path.back()->value; }
+        pointer operator->() const { return &path.back()->value; }
+
+        iterator &operator++()
+        {
+            const NodeType *node = path.back();
+            path.pop_back();
+            pushLeft(node->right.get());
+            return *this;
+        }
+
+        iterator operator++(int)
+        {
+            iterator old = *this;
+            ++*this;
+            return old;
+        }
+
+        bool operator==(const iterator &other) const
+        {
+            if (path.empty() || other.path.empty())
+                return path.empty() == other.path.empty();
+            return path.back() == other.path.back();
+        }
+        bool operator!=(const iterator &other) const { return !(*this == other); }
+    };
+
+    PersistentRedBlackTree() {}
+
+    size_t size() const
+    {
+        return count;
+    }
+
+    bool empty() const
+    {
+        return root == nullptr;
+    }
+
+    // Keys are unique, inserting a key that is already there returns the
+    // same version.
+    PersistentRedBlackTree Insert(const T &value) const
+    {
+        if (findNode(value) != nullptr)
+            return *this;
+        return PersistentRedBlackTree(blacken(insert(root, value)), count + 1);
+    }
+
+    PersistentRedBlackTree Delete(const T &value) const
+    {
+        if (findNode(value) == nullptr)
+            return *this;
+        Link newRoot = remove(root, value);
+        if (isRedNode(newRoot))
+            newRoot = blacken(newRoot);
+        return PersistentRedBlackTree(std::move(newRoot), count - 1);
+    }
+
+    const T *find(const T &value) const
+    {
+        const NodeType *node = findNode(value);
+        return node == nullptr ? nullptr : &node->value;
+    }
+
+    bool contains(const T &value) const
+    {
+        return findNode(value) != nullptr;
+    }
+
+    iterator begin() const { return iterator(root.get()); }
+    iterator end() const { return iterator(); }
+
+    void print() const
+    {
+        print(root.get(), 0);
+    }
+};
+
+#ifndef NO_MAIN
+int main()
+{
+    PersistentRedBlackTree<int> tree;
+    for (int value : {200, 158, 2500, 555, 0})
+        tree = tree.Insert(value);
+
+    PersistentRedBlackTree<int> snapshot = tree;
+    tree = tree.Delete(200).Insert(42);
+
+    cout << "snapshot:";
+    for (int value : snapshot)
+        cout << " " << value;
+    cout << "\ncurrent:";
+    for (int value : tree)
+        cout << " " << value;
+    cout << endl;
+    tree.print();
+    return 0;
+}
+#endif
+
+#endif
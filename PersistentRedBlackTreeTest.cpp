@@ -0,0 +1,84 @@
+#define NO_MAIN
+#include <iostream>
+#include <cassert>
+#include <random>
+#include <set>
+#include <vector>
+#include "PersistentRedBlackTree.cpp"
+
+bool sameContents(const PersistentRedBlackTree<int> &tree, const set<int> &reference) {
+    return tree.size() == reference.size() &&
+           equal(tree.begin(), tree.end(), reference.begin(), reference.end());
+}
+
+void testOldVersionsUnchanged() {
+    vector<PersistentRedBlackTree<int>> versions;
+    vector<set<int>> references;
+    PersistentRedBlackTree<int> tree;
+    set<int> reference;
+    mt19937 gen(1);
+    for (int i = 0; i < 20000; i++) {
+        int value = gen() % 1000;
+        if (gen() % 3 != 0) {
+            tree = tree.Insert(value);
+            reference.insert(value);
+        }
+        else {
+            tree = tree.Delete(value);
+            reference.erase(value);
+        }
+        if (i % 1000 == 0) {
+            versions.push_back(tree);
+            references.push_back(reference);
+        }
+    }
+    assert(sameContents(tree, reference));
+    for (size_t v = 0; v < versions.size(); v++) {
+        assert(sameContents(versions[v], references[v]));
+    }
+
+    // Deleting everything from the newest version leaves the others intact,
+    // and so does dropping it.
+    for (int value : reference) {
+        tree = tree.Delete(value);
+    }
+    assert(tree.empty() && tree.size() == 0);
+    tree = PersistentRedBlackTree<int>();
+    for (size_t v = 0; v < versions.size(); v++) {
+        assert(sameContents(versions[v], references[v]));
+    }
+}
+
+void testBranches() {
+    PersistentRedBlackTree<int> base;
+    for (int i = 0; i < 100; i++) {
+        base = base.Insert(i);
+    }
+    PersistentRedBlackTree<int> evens = base;
+    PersistentRedBlackTree<int> odds = base;
+    for (int i = 0; i < 100; i++) {
+        if (i % 2 == 0) {
+            odds = odds.Delete(i);
+        }
+        else {
+            evens = evens.Delete(i);
+        }
+    }
+    assert(base.size() == 100 && evens.size() == 50 && odds.size() == 50);
+    for (int i = 0; i < 100; i++) {
+        assert(base.contains(i));
+        assert(evens.contains(i) == (i % 2 == 0));
+        assert(odds.contains(i) == (i % 2 == 1));
+    }
+
+    // Inserting a present key or deleting a missing one keeps the version.
+    PersistentRedBlackTree<int> same = evens.Insert(2).Delete(3);
+    assert(same.begin() == evens.begin() && same.size() == evens.size());
+}
+
+int main() {
+    testOldVersionsUnchanged();
+    testBranches();
+    std::cout << "All tests passed!" << std::endl;
+    return 0;
+}
@@ -1,8 +1,135 @@
+#ifndef REDBLACKTREE_CPP
+#define REDBLACKTREE_CPP
+
 #include <iostream>
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "NodeAllocator.cpp"
+#include "Snapshot.cpp"
+#include "WorkStealingPool.cpp"
 using namespace std;
 
-template <class T>
-struct Node
+#ifdef REDBLACKTREE_STATS
+// Work done by Insert, Delete and the lookups of one tree, compiled in
+// only with -DREDBLACKTREE_STATS. Join, split and the set operations are
+// not counted.
+struct RedBlackTreeStats
+{
+    size_t rotations = 0;
+    size_t recolors = 0;
+    size_t searches = 0;
+    size_t comparisons = 0;
+    size_t allocatedBytes = 0;
+    size_t freedBytes = 0;
+};
+#define REDBLACKTREE_COUNT(counter, amount) (statistics.counter += (amount))
+#else
+#define REDBLACKTREE_COUNT(counter, amount) ((void)0)
+#endif
+
+// Extra per-node data kept up to date through rotations and relinks.
+// update() recomputes a node from its children.
+struct NoAugmentation
+{
+    static const bool enabled = false;
+
+    template <class T>
+    struct Fields
+    {
+    };
+
+    template <class NodeT>
+    static void update(NodeT *) {}
+};
+
+// Subtree sizes, for select/rank/count in O(log n).
+struct SubtreeSize
+{
+    static const bool enabled = true;
+
+    template <class T>
+    struct Fields
+    {
+        size_t size = 1;
+    };
+
+    template <class NodeT>
+    static size_t sizeOf(const NodeT *node)
+    {
+        return node == nullptr ? 0 : node->size;
+    }
+
+    template <class NodeT>
+    static void update(NodeT *node)
+    {
+        node->size = 1 + sizeOf(node->left) + sizeOf(node->right);
+    }
+};
+
+// Closed interval [lo, hi], ordered by lo and then by hi.
+template <class Bound>
+struct Interval
+{
+    typedef Bound BoundType;
+
+    Bound lo;
+    Bound hi;
+
+    bool overlaps(const Bound &otherLo, const Bound &otherHi) const
+    {
+        return !(otherHi < lo) && !(hi < otherLo);
+    }
+
+    bool operator<(const Interval &other) const
+    {
+        return lo < other.lo || (!(other.lo < lo) && hi < other.hi);
+    }
+    bool operator==(const Interval &other) const { return !(*this < other) && !(other < *this); }
+    bool operator!=(const Interval &other) const { return !(*this == other); }
+};
+
+template <class Bound>
+ostream &operator<<(ostream &out, const Interval<Bound> &interval)
+{
+    return out << "[" << interval.lo << ", " << interval.hi << "]";
+}
+
+// Largest hi in each subtree of Interval values, so overlap queries can
+// skip subtrees that end before the query starts.
+struct IntervalMax
+{
+    static const bool enabled = true;
+
+    template <class T>
+    struct Fields
+    {
+        typename T::BoundType maxHi{};
+    };
+
+    template <class NodeT>
+    static void update(NodeT *node)
+    {
+        node->maxHi = node->value.hi;
+        if (node->left != nullptr && node->maxHi < node->left->maxHi)
+            node->maxHi = node->left->maxHi;
+        if (node->right != nullptr && node->maxHi < node->right->maxHi)
+            node->maxHi = node->right->maxHi;
+    }
+};
+
+template <class T, class Augmentation = NoAugmentation>
+struct Node : Augmentation::template Fields<T>
 {
     T value;
     Node *left = nullptr;
@@ -11,12 +138,512 @@ struct Node
     bool isRed = true;
 };
 
-template <class T>
+template <class T, template <class> class Allocator = SlabAllocator, class Augmentation = NoAugmentation>
 class RedBlackTree
 {
-    Node<T> *root = nullptr;
+    typedef Node<T, Augmentation> NodeType;
+
+    NodeType *root = nullptr;
+    Allocator<NodeType> allocator;
+    // Splitting a tree without subtree sizes loses track of how many
+    // nodes each side has, size() counts them again on demand.
+    static const size_t UnknownSize = (size_t)-1;
+    mutable size_t nodeCount = 0;
+#ifdef REDBLACKTREE_STATS
+    mutable RedBlackTreeStats statistics;
+#endif
+
+    template <class... Args>
+    NodeType *createNode(Args &&...args)
+    {
+        NodeType *node = new (allocator.allocate()) NodeType{{}, T(std::forward<Args>(args)...)};
+        Augmentation::update(node);
+        REDBLACKTREE_COUNT(allocatedBytes, sizeof(NodeType));
+        return node;
+    }
+
+    void destroyNode(NodeType *node)
+    {
+        node->~NodeType();
+        allocator.deallocate(node);
+        REDBLACKTREE_COUNT(freedBytes, sizeof(NodeType));
+    }
+
+    // Nodes only need a walk when their values have destructors or the
+    // allocator cannot drop all of its memory at once.
+    void destroyAll()
+    {
+        REDBLACKTREE_COUNT(freedBytes, size() * sizeof(NodeType));
+        const bool bulk = Allocator<NodeType>::bulkRelease;
+        if (!bulk || !is_trivially_destructible<T>::value)
+        {
+            NodeType *node = root;
+            while (node != nullptr)
+            {
+                if (node->left != nullptr)
+                    node = node->left;
+                else if (node->right != nullptr)
+                    node = node->right;
+                else
+                {
+                    NodeType *parent = node->parent;
+                    if (parent != nullptr)
+                    {
+                        if (parent->left == node)
+                            parent->left = nullptr;
+                        else
+                            parent->right = nullptr;
+                    }
+                    node->~NodeType();
+                    if (!bulk)
+                        allocator.deallocate(node);
+                    node = parent;
+                }
+            }
+        }
+        allocator.release();
+        root = nullptr;
+        nodeCount = 0;
+    }
+
+    static const size_t ParallelBuildThreshold = 1 << 16;
+
+    // Builds values[lo, hi) into a balanced subtree. Node i of the range
+    // goes to block[i] when there is a block. All nodes on the deepest
+    // level are red, so every path has redDepth black nodes.
+    template <class Iterator>
+    NodeType *buildBalanced(Iterator values, NodeType *block, size_t lo, size_t hi, int depth,
+                            int redDepth, int parallelDepth, NodeType *parent)
+    {
+        if (lo >= hi)
+            return nullptr;
+
+        size_t mid = lo + (hi - lo) / 2;
+        NodeType *node = block != nullptr ? block + mid : allocator.allocate();
+        new (node) NodeType{{}, values[mid]};
+        node->parent = parent;
+        node->isRed = depth == redDepth && depth > 0;
+
+        if (depth < parallelDepth && hi - lo >= ParallelBuildThreshold)
+        {
+            thread leftBuilder([&]()
+                               { node->left = buildBalanced(values, block, lo, mid, depth + 1, redDepth, parallelDepth, node); });
+            node->right = buildBalanced(values, block, mid + 1, hi, depth + 1, redDepth, parallelDepth, node);
+            leftBuilder.join();
+        }
+        else
+        {
+            node->left = buildBalanced(values, block, lo, mid, depth + 1, redDepth, parallelDepth, node);
+            node->right = buildBalanced(values, block, mid + 1, hi, depth + 1, redDepth, parallelDepth, node);
+        }
+        Augmentation::update(node);
+        return node;
+    }
+
+    template <class Iterator>
+    void buildSorted(Iterator values, size_t n)
+    {
+        int redDepth = 0;
+        while ((size_t(2) << redDepth) <= n)
+            redDepth++;
+
+        NodeType *block = allocator.allocateBlock(n);
+        int parallelDepth = 0;
+        if (block != nullptr)
+        {
+            unsigned threads = thread::hardware_concurrency();
+            while ((1u << parallelDepth) < threads)
+                parallelDepth++;
+        }
+
+        root = buildBalanced(values, block, 0, n, 0, redDepth, parallelDepth, nullptr);
+        root->isRed = false;
+        nodeCount = n;
+        REDBLACKTREE_COUNT(allocatedBytes, n * sizeof(NodeType));
+    }
+
+    // Join-based algorithms (Blelloch, Ferizovic and Sun, "Just Join for
+    // Parallel Ordered Sets"). They work on detached subtrees whose roots may
+    // be red and hand back the nodes they drop instead of freeing them, so
+    // the recursive halves can run on different threads.
+
+    static bool isRedNode(const NodeType *node)
+    {
+        return node != nullptr && node->isRed;
+    }
+
+    static int blackHeight(const NodeType *node)
+    {
+        int height = 0;
+        for (; node != nullptr; node = node->left)
+            if (!node->isRed)
+                height++;
+        return height;
+    }
+
+    static void setLeft(NodeType *node, NodeType *child)
+    {
+        node->left = child;
+        if (child != nullptr)
+            child->parent = node;
+    }
+
+    static void setRight(NodeType *node, NodeType *child)
+    {
+        node->right = child;
+        if (child != nullptr)
+            child->parent = node;
+    }
+
+    static NodeType *detach(NodeType *node)
+    {
+        if (node != nullptr)
+            node->parent = nullptr;
+        return node;
+    }
+
+    static NodeType *rotateSubtreeLeft(NodeType *node)
+    {
+        NodeType *newParent = node->right;
+        setRight(node, newParent->left);
+        setLeft(newParent, node);
+        Augmentation::update(node);
+        Augmentation::update(newParent);
+        return newParent;
+    }
+
+    static NodeType *rotateSubtreeRight(NodeType *node)
+    {
+        NodeType *newParent = node->left;
+        setLeft(node, newParent->right);
+        setRight(newParent, node);
+        Augmentation::update(node);
+        Augmentation::update(newParent);
+        return newParent;
+    }
+
+    // left has the larger black height: walk down its right spine.
+    static NodeType *joinRight(NodeType *left, NodeType *middle, NodeType *right, int leftHeight, int rightHeight)
+    {
+        if (!isRedNode(left) && leftHeight == rightHeight)
+        {
+            setLeft(middle, left);
+            setRight(middle, right);
+            middle->isRed = true;
+            Augmentation::update(middle);
+            return middle;
+        }
+        int childHeight = leftHeight - (isRedNode(left) ? 0 : 1);
+        setRight(left, joinRight(left->right, middle, right, childHeight, rightHeight));
+        Augmentation::update(left);
+        if (!isRedNode(left) && isRedNode(left->right) && isRedNode(left->right->right))
+        {
+            left->right->right->isRed = false;
+            return rotateSubtreeLeft(left);
+        }
+        return left;
+    }
+
+    static NodeType *joinLeft(NodeType *left, NodeType *middle, NodeType *right, int leftHeight, int rightHeight)
+    {
+        if (!isRedNode(right) && leftHeight == rightHeight)
+        {
+            setLeft(middle, left);
+            setRight(middle, right);
+            middle->isRed = true;
+            Augmentation::update(middle);
+            return middle;
+        }
+        int childHeight = rightHeight - (isRedNode(right) ? 0 : 1);
+        setLeft(right, joinLeft(left, middle, right->left, leftHeight, childHeight));
+        Augmentation::update(right);
+        if (!isRedNode(right) && isRedNode(right->left) && isRedNode(right->left->left))
+        {
+            right->left->left->isRed = false;
+            return rotateSubtreeRight(right);
+        }
+        return right;
+    }
+
+    // All of left < middle < all of right.
+    static NodeType *join(NodeType *left, NodeType *middle, NodeType *right)
+    {
+        int leftHeight = blackHeight(left);
+        int rightHeight = blackHeight(right);
+        NodeType *result;
+        if (leftHeight > rightHeight)
+        {
+            result = joinRight(left, middle, right, leftHeight, rightHeight);
+            if (isRedNode(result) && isRedNode(result->right))
+                result->isRed = false;
+        }
+        else if (rightHeight > leftHeight)
+        {
+            result = joinLeft(left, middle, right, leftHeight, rightHeight);
+            if (isRedNode(result) && isRedNode(result->left))
+                result->isRed = false;
+        }
+        else
+        {
+            setLeft(middle, left);
+            setRight(middle, right);
+            middle->isRed = !isRedNode(left) && !isRedNode(right);
+            Augmentation::update(middle);
+            result = middle;
+        }
+        return detach(result);
+    }
+
+    static void splitLast(NodeType *tree, NodeType *&rest, NodeType *&last)
+    {
+        NodeType *left = detach(tree->left);
+        NodeType *right = detach(tree->right);
+        if (right == nullptr)
+        {
+            rest = left;
+            last = tree;
+            return;
+        }
+        NodeType *restRight;
+        splitLast(right, restRight, last);
+        rest = join(left, tree, restRight);
+    }
+
+    // All of left < all of right.
+    static NodeType *join2(NodeType *left, NodeType *right)
+    {
+        if (left == nullptr)
+            return right;
+        if (right == nullptr)
+            return left;
+        NodeType *rest;
+        NodeType *last;
+        splitLast(left, rest, last);
+        return join(rest, last, right);
+    }
+
+    // less gets the keys below key, greater the keys above it and found the
+    // node equal to key, if there is one.
+    static void split(NodeType *tree, const T &key, NodeType *&less, NodeType *&found, NodeType *&greater)
+    {
+        if (tree == nullptr)
+        {
+            less = found = greater = nullptr;
+            return;
+        }
+        NodeType *left = detach(tree->left);
+        NodeType *right = detach(tree->right);
+        if (key < tree->value)
+        {
+            NodeType *middle;
+            split(left, key, less, found, middle);
+            greater = join(middle, tree, right);
+        }
+        else if (tree->value < key)
+        {
+            NodeType *middle;
+            split(right, key, middle, found, greater);
+            less = join(left, tree, middle);
+        }
+        else
+        {
+            less = left;
+            greater = right;
+            found = tree;
+        }
+    }
+
+    static void collect(NodeType *tree, vector<NodeType *> &dropped)
+    {
+        if (tree == nullptr)
+            return;
+        collect(tree->left, dropped);
+        collect(tree->right, dropped);
+        dropped.push_back(tree);
+    }
+
+    enum SetOperation
+    {
+        UnionOperation,
+        IntersectionOperation,
+        DifferenceOperation
+    };
+
+    // Trees this small are not worth a task of their own.
+    static const int ParallelBlackHeight = 8;
+
+    template <SetOperation Operation>
+    static void forkJoin(NodeType *leftA, NodeType *leftB, NodeType *rightA, NodeType *rightB,
+                         NodeType *&left, NodeType *&right, int depth, vector<NodeType *> &dropped)
+    {
+        WorkStealingPool &pool = WorkStealingPool::shared();
+        int parallelDepth = 0;
+        while ((size_t(1) << parallelDepth) < pool.threadCount() * 4)
+            parallelDepth++;
+
+        if (pool.threadCount() > 1 && depth < parallelDepth &&
+            max(blackHeight(leftA), blackHeight(rightA)) >= ParallelBlackHeight)
+        {
+            vector<NodeType *> droppedRight;
+            pool.invoke([&]()
+                        { left = setOperation<Operation>(leftA, leftB, depth + 1, dropped); },
+                        [&]()
+                        { right = setOperation<Operation>(rightA, rightB, depth + 1, droppedRight); });
+            dropped.insert(dropped.end(), droppedRight.begin(), droppedRight.end());
+        }
+        else
+        {
+            left = setOperation<Operation>(leftA, leftB, depth + 1, dropped);
+            right = setOperation<Operation>(rightA, rightB, depth + 1, dropped);
+        }
+    }
+
+    template <SetOperation Operation>
+    static NodeType *setOperation(NodeType *a, NodeType *b, int depth, vector<NodeType *> &dropped)
+    {
+        if (a == nullptr || b == nullptr)
+        {
+            if (Operation == UnionOperation)
+                return a != nullptr ? a : b;
+            if (Operation == DifferenceOperation && a != nullptr)
+                return a;
+            collect(a, dropped);
+            collect(b, dropped);
+            return nullptr;
+        }
+
+        NodeType *left;
+        NodeType *right;
+        NodeType *less;
+        NodeType *found;
+        NodeType *greater;
+        if (Operation == DifferenceOperation)
+        {
+            // split a around the root of b, b's root is never kept
+            split(a, b->value, less, found, greater);
+            NodeType *bLeft = detach(b->left);
+            NodeType *bRight = detach(b->right);
+            forkJoin<Operation>(less, bLeft, greater, bRight, left, right, depth, dropped);
+            dropped.push_back(b);
+            if (found != nullptr)
+                dropped.push_back(found);
+            return join2(left, right);
+        }
+
+        split(b, a->value, less, found, greater);
+        NodeType *aLeft = detach(a->left);
+        NodeType *aRight = detach(a->right);
+        forkJoin<Operation>(aLeft, less, aRight, greater, left, right, depth, dropped);
+        if (Operation == UnionOperation || found != nullptr)
+        {
+            if (found != nullptr)
+                dropped.push_back(found);
+            return join(left, a, right);
+        }
+        dropped.push_back(a);
+        return join2(left, right);
+    }
+
+    template <SetOperation Operation>
+    void combine(RedBlackTree &other)
+    {
+        if (&other == this)
+        {
+            if (Operation == DifferenceOperation)
+                clear();
+            return;
+        }
+        size_t total = UnknownSize;
+        if (nodeCount != UnknownSize && other.nodeCount != UnknownSize)
+            total = nodeCount + other.nodeCount;
+
+        allocator.adopt(other.allocator);
+        vector<NodeType *> dropped;
+        root = setOperation<Operation>(root, other.root, 0, dropped);
+        if (root != nullptr)
+            root->isRed = false;
+        other.root = nullptr;
+        other.nodeCount = 0;
+
+        for (NodeType *node : dropped)
+            destroyNode(node);
+        nodeCount = total == UnknownSize ? UnknownSize : total - dropped.size();
+    }
+
+    // Hangs a fresh node below parent (or makes it the root) and rebalances.
+    void linkNode(NodeType *newNode, NodeType *parent, bool asLeftChild)
+    {
+        if (nodeCount != UnknownSize)
+            nodeCount++;
 
-    void replaceNode(Node<T> *oldNode, Node<T> *newNode)
+        if (parent == nullptr)
+        {
+            root = newNode;
+            root->isRed = false;
+            return;
+        }
+
+        newNode->parent = parent;
+        if (asLeftChild)
+            parent->left = newNode;
+        else
+            parent->right = newNode;
+
+        updateUpward(parent);
+        FixInsert(newNode);
+    }
+
+    void removeNode(NodeType *target)
+    {
+        NodeType *replacement = nullptr;
+        NodeType *replacementParent = nullptr;
+        bool targetOriginalColor = target->isRed;
+
+        if (target->left == nullptr)
+        {
+            replacement = target->right;
+            replacementParent = target->parent;
+            replaceNode(target, target->right);
+        }
+        else if (target->right == nullptr)
+        {
+            replacement = target->left;
+            replacementParent = target->parent;
+            replaceNode(target, target->left);
+        }
+        else
+        {
+            NodeType *successor = getMinimum(target->right);
+            targetOriginalColor = successor->isRed;
+            replacement = successor->right;
+            replacementParent = successor;
+
+            if (successor->parent != target)
+            {
+                replacementParent = successor->parent;
+                replaceNode(successor, successor->right);
+                successor->right = target->right;
+                if (successor->right != nullptr)
+                    successor->right->parent = successor;
+            }
+
+            replaceNode(target, successor);
+            successor->left = target->left;
+            if (successor->left != nullptr)
+                successor->left->parent = successor;
+            successor->isRed = target->isRed;
+        }
+
+        updateUpward(replacementParent);
+        if (!targetOriginalColor)
+            FixDelete(replacement, replacementParent);
+
+        destroyNode(target);
+        if (nodeCount != UnknownSize)
+            nodeCount--;
+    }
+
+    void replaceNode(NodeType *oldNode, NodeType *newNode)
     {
         if (oldNode == root)
             root = newNode;
@@ -29,105 +656,210 @@ class RedBlackTree
             newNode->parent = oldNode->parent;
     }
 
-    Node<T> *getMinimum(Node<T> *node)
+    static NodeType *getMinimum(NodeType *node)
     {
         while (node->left != nullptr)
             node = node->left;
         return node;
     }
 
-    void FixDelete(Node<T> *node)
+    static NodeType *getMaximum(NodeType *node)
+    {
+        while (node->right != nullptr)
+            node = node->right;
+        return node;
+    }
+
+    static NodeType *successor(NodeType *node)
+    {
+        if (node->right != nullptr)
+            return getMinimum(node->right);
+        while (node->parent != nullptr && node == node->parent->right)
+            node = node->parent;
+        return node->parent;
+    }
+
+    static NodeType *predecessor(NodeType *node)
+    {
+        if (node->left != nullptr)
+            return getMaximum(node->left);
+        while (node->parent != nullptr && node == node->parent->left)
+            node = node->parent;
+        return node->parent;
+    }
+
+    void recolor(NodeType *node, bool red)
+    {
+        if (node->isRed != red)
+            REDBLACKTREE_COUNT(recolors, 1);
+        node->isRed = red;
+    }
+
+    // parent is passed separately because node may be an empty subtree.
+    void FixDelete(NodeType *node, NodeType *parent)
     {
         while (node != root && (node == nullptr || !node->isRed))
         {
-            if (node == node->parent->left)
+            if (node == parent->left)
             {
-                Node<T> *sibling = node->parent->right;
+                NodeType *sibling = parent->right;
 
                 if (sibling != nullptr && sibling->isRed)
                 {
-                    sibling->isRed = false;
-                    node->parent->isRed = true;
-                    leftRotate(node->parent);
-                    sibling = node->parent->right;
+                    recolor(sibling, false);
+                    recolor(parent, true);
+                    leftRotate(parent);
+                    sibling = parent->right;
                 }
 
                 if ((sibling->left == nullptr || !sibling->left->isRed) && (sibling->right == nullptr || !sibling->right->isRed))
                 {
-                    sibling->isRed = true;
-                    node = node->parent;
+                    recolor(sibling, true);
+                    node = parent;
+                    parent = node->parent;
                 }
                 else
                 {
                     if (sibling->right == nullptr || !sibling->right->isRed)
                     {
-                        sibling->left->isRed = false;
-                        sibling->isRed = true;
+                        recolor(sibling->left, false);
+                        recolor(sibling, true);
                         rightRotate(sibling);
-                        sibling = node->parent->right;
+                        sibling = parent->right;
                     }
 
-                    sibling->isRed = node->parent->isRed;
-                    node->parent->isRed = false;
+                    recolor(sibling, parent->isRed);
+                    recolor(parent, false);
 
                     if (sibling->right != nullptr)
-                        sibling->right->isRed = false;
+                        recolor(sibling->right, false);
 
-                    leftRotate(node->parent);
+                    leftRotate(parent);
                     node = root;
                 }
             }
             else
             {
-                Node<T> *sibling = node->parent->left;
+                NodeType *sibling = parent->left;
 
                 if (sibling != nullptr && sibling->isRed)
                 {
-                    sibling->isRed = false;
-                    node->parent->isRed = true;
-                    rightRotate(node->parent);
-                    sibling = node->parent->left;
+                    recolor(sibling, false);
+                    recolor(parent, true);
+                    rightRotate(parent);
+                    sibling = parent->left;
                 }
 
                 if ((sibling->right == nullptr || !sibling->right->isRed) &&
                     (sibling->left == nullptr || !sibling->left->isRed))
                 {
-                    sibling->isRed = true;
-                    node = node->parent;
+                    recolor(sibling, true);
+                    node = parent;
+                    parent = node->parent;
                 }
                 else
                 {
                     if (sibling->left == nullptr || !sibling->left->isRed)
                     {
                         if (sibling->right != nullptr)
-                            sibling->right->isRed = false;
+                            recolor(sibling->right, false);
 
-                        sibling->isRed = true;
+                        recolor(sibling, true);
                         leftRotate(sibling);
-                        sibling = node->parent->left;
+                        sibling = parent->left;
                     }
 
-                    sibling->isRed = node->parent->isRed;
-                    node->parent->isRed = false;
+                    recolor(sibling, parent->isRed);
+                    recolor(parent, false);
 
                     if (sibling->left != nullptr)
-                        sibling->left->isRed = false;
+                        recolor(sibling->left, false);
 
-                    rightRotate(node->parent);
+                    rightRotate(parent);
                     node = root;
                 }
             }
         }
 
         if (node != nullptr)
-            node->isRed = false;
+            recolor(node, false);
     }
 
-    void leftRotate(Node<T> *node)
+    // In-order walk that skips subtrees ending before lo and stops once
+    // intervals start after hi.
+    template <class Bound>
+    static void collectOverlapping(const NodeType *node, const Bound &lo, const Bound &hi, vector<T> &result)
     {
-        Node<T> *newParent = node->right;
-        node->right = newParent->left;
-
+        while (node != nullptr && !(node->maxHi < lo))
+        {
+            collectOverlapping(node->left, lo, hi, result);
+            if (hi < node->value.lo)
+                return;
+            if (!(node->value.hi < lo))
+                result.push_back(node->value);
+            node = node->right;
+        }
+    }
+
+    static int subtreeHeight(const NodeType *node)
+    {
+        if (node == nullptr)
+            return 0;
+        return 1 + max(subtreeHeight(node->left), subtreeHeight(node->right));
+    }
+
+    // Black height of the subtree, or -1 if it breaks an invariant.
+    static int validateSubtree(const NodeType *node, const NodeType *parent, size_t &count)
+    {
+        if (node == nullptr)
+            return 1;
+        count++;
+        if (node->parent != parent)
+            return -1;
+        if (node->isRed && (isRedNode(node->left) || isRedNode(node->right)))
+            return -1;
+        if constexpr (is_same<Augmentation, SubtreeSize>::value)
+        {
+            if (node->size != 1 + SubtreeSize::sizeOf(node->left) + SubtreeSize::sizeOf(node->right))
+                return -1;
+        }
+        if constexpr (is_same<Augmentation, IntervalMax>::value)
+        {
+            typename T::BoundType expected = node->value.hi;
+            if (node->left != nullptr && expected < node->left->maxHi)
+                expected = node->left->maxHi;
+            if (node->right != nullptr && expected < node->right->maxHi)
+                expected = node->right->maxHi;
+            if (expected < node->maxHi || node->maxHi < expected)
+                return -1;
+        }
+
+        int leftHeight = validateSubtree(node->left, node, count);
+        int rightHeight = validateSubtree(node->right, node, count);
+        if (leftHeight < 0 || leftHeight != rightHeight)
+            return -1;
+        return leftHeight + (node->isRed ? 0 : 1);
+    }
+
+    // Recomputes the augmentation from node up to the root.
+    void updateUpward(NodeType *node)
+    {
+        if constexpr (Augmentation::enabled)
+        {
+            while (node != nullptr)
+            {
+                Augmentation::update(node);
+                node = node->parent;
+            }
+        }
+    }
+
+    void leftRotate(NodeType *node)
+    {
+        REDBLACKTREE_COUNT(rotations, 1);
+        NodeType *newParent = node->right;
+        node->right = newParent->left;
+
         if (newParent->left != nullptr)
             newParent->left->parent = node;
 
@@ -142,11 +874,14 @@ class RedBlackTree
 
         newParent->left = node;
         node->parent = newParent;
+        Augmentation::update(node);
+        Augmentation::update(newParent);
     }
 
-    void rightRotate(Node<T> *node)
+    void rightRotate(NodeType *node)
     {
-        Node<T> *newParent = node->left;
+        REDBLACKTREE_COUNT(rotations, 1);
+        NodeType *newParent = node->left;
         node->left = newParent->right;
 
         if (newParent->right != nullptr)
@@ -163,20 +898,22 @@ class RedBlackTree
 
         newParent->right = node;
         node->parent = newParent;
+        Augmentation::update(node);
+        Augmentation::update(newParent);
     }
 
-    void FixInsert(Node<T> *node)
+    void FixInsert(NodeType *node)
     {
         while (node != root && node->parent->isRed)
         {
             if (node->parent == node->parent->parent->left)
             {
-                Node<T> *uncle = node->parent->parent->right;
+                NodeType *uncle = node->parent->parent->right;
                 if (uncle != nullptr && uncle->isRed)
                 {
-                    node->parent->isRed = false;
-                    uncle->isRed = false;
-                    node->parent->parent->isRed = true;
+                    recolor(node->parent, false);
+                    recolor(uncle, false);
+                    recolor(node->parent->parent, true);
                     node = node->parent->parent;
                 }
                 else
@@ -186,19 +923,19 @@ class RedBlackTree
                         node = node->parent;
                         leftRotate(node);
                     }
-                    node->parent->isRed = false;
-                    node->parent->parent->isRed = true;
+                    recolor(node->parent, false);
+                    recolor(node->parent->parent, true);
                     rightRotate(node->parent->parent);
                 }
             }
             else
             {
-                Node<T> *uncle = node->parent->parent->left;
+                NodeType *uncle = node->parent->parent->left;
                 if (uncle != nullptr && uncle->isRed)
                 {
-                    node->parent->isRed = false;
-                    uncle->isRed = false;
-                    node->parent->parent->isRed = true;
+                    recolor(node->parent, false);
+                    recolor(uncle, false);
+                    recolor(node->parent->parent, true);
                     node = node->parent->parent;
                 }
                 else
@@ -208,16 +945,16 @@ class RedBlackTree
                         node = node->parent;
                         rightRotate(node);
                     }
-                    node->parent->isRed = false;
-                    node->parent->parent->isRed = true;
+                    recolor(node->parent, false);
+                    recolor(node->parent->parent, true);
                     leftRotate(node->parent->parent);
                 }
             }
         }
-        root->isRed = false;
+        recolor(root, false);
     }
 
-    void print(Node<T> *node, int depth = 0)
+    void print(NodeType *node, int depth = 0)
     {
         if (node != nullptr)
         {
@@ -232,47 +969,256 @@ class RedBlackTree
     }
 
 public:
-    void Insert(T value)
+    RedBlackTree() {}
+
+    // Builds the tree from sorted values in O(n), see bulkLoad.
+    template <typename Container>
+    explicit RedBlackTree(const Container &sortedValues)
     {
-        Node<T> *newNode = new Node<T>();
-        newNode->value = value;
+        bulkLoad(std::begin(sortedValues), std::end(sortedValues));
+    }
+    RedBlackTree(const RedBlackTree &) = delete;
+    RedBlackTree &operator=(const RedBlackTree &) = delete;
+
+    // Takes the nodes and their memory, other is left empty.
+    RedBlackTree(RedBlackTree &&other)
+    {
+        *this = std::move(other);
+    }
+
+    RedBlackTree &operator=(RedBlackTree &&other)
+    {
+        if (&other == this)
+            return *this;
+        destroyAll();
+        allocator.adopt(other.allocator);
+        root = other.root;
+        nodeCount = other.nodeCount;
+        other.root = nullptr;
+        other.nodeCount = 0;
+        return *this;
+    }
+
+    ~RedBlackTree()
+    {
+        destroyAll();
+    }
 
-        if (root == nullptr)
+    void clear()
+    {
+        destroyAll();
+    }
+
+    // In-order iterator, walks the parent pointers so it needs no stack.
+    class iterator
+    {
+        friend class RedBlackTree;
+        const RedBlackTree *tree = nullptr;
+        NodeType *node = nullptr;
+
+        iterator(const RedBlackTree *tree, NodeType *node) : tree(tree), node(node) {}
+
+    public:
+        typedef bidirectional_iterator_tag iterator_category;
+        typedef T value_type;
+        typedef ptrdiff_t difference_type;
+        typedef const T *pointer;
+        typedef const T &reference;
+
+        iterator() {}
+
+        const T &operator*() const { return node->value; }
+        const T *operator->() const { return &node->value; }
+
+        iterator &operator++()
         {
-            root = newNode;
-            root->isRed = false;
-            return;
+            node = successor(node);
+            return *this;
+        }
+        iterator operator++(int)
+        {
+            iterator old = *this;
+            ++*this;
+            return old;
+        }
+        iterator &operator--()
+        {
+            if (node == nullptr)
+                node = getMaximum(tree->root);
+            else
+                node = predecessor(node);
+            return *this;
+        }
+        iterator operator--(int)
+        {
+            iterator old = *this;
+            --*this;
+            return old;
         }
 
-        Node<T> *parent = nullptr;
-        Node<T> *current = root;
+        bool operator==(const iterator &other) const { return node == other.node; }
+        bool operator!=(const iterator &other) const { return node != other.node; }
+    };
+    typedef iterator const_iterator;
 
+    // Half-open [lo, hi) slice of the tree, usable in a range-for.
+    class Range
+    {
+        iterator first;
+        iterator last;
+
+    public:
+        Range(iterator first, iterator last) : first(first), last(last) {}
+        iterator begin() const { return first; }
+        iterator end() const { return last; }
+        bool empty() const { return first == last; }
+    };
+
+    iterator begin() const
+    {
+        return iterator(this, root == nullptr ? nullptr : getMinimum(root));
+    }
+
+    iterator end() const
+    {
+        return iterator(this, nullptr);
+    }
+
+    // First element that is not less than value. Key may be any type that
+    // compares with T through operator<, like the lookups below.
+    template <class Key>
+    iterator lower_bound(const Key &value) const
+    {
+        NodeType *result = nullptr;
+        NodeType *current = root;
+        REDBLACKTREE_COUNT(searches, 1);
         while (current != nullptr)
         {
-            parent = current;
+            REDBLACKTREE_COUNT(comparisons, 1);
+            if (current->value < value)
+                current = current->right;
+            else
+            {
+                result = current;
+                current = current->left;
+            }
+        }
+        return iterator(this, result);
+    }
+
+    // First element that is greater than value.
+    template <class Key>
+    iterator upper_bound(const Key &value) const
+    {
+        NodeType *result = nullptr;
+        NodeType *current = root;
+        REDBLACKTREE_COUNT(searches, 1);
+        while (current != nullptr)
+        {
+            REDBLACKTREE_COUNT(comparisons, 1);
             if (value < current->value)
+            {
+                result = current;
                 current = current->left;
+            }
             else
                 current = current->right;
         }
+        return iterator(this, result);
+    }
 
-        newNode->parent = parent;
-        if (value < parent->value)
-            parent->left = newNode;
-        else
-            parent->right = newNode;
+    template <class Key>
+    iterator find(const Key &value) const
+    {
+        iterator it = lower_bound(value);
+        if (it != end() && !(value < *it))
+            return it;
+        return end();
+    }
 
-        FixInsert(newNode);
+    template <class Key>
+    bool contains(const Key &value) const
+    {
+        return find(value) != end();
+    }
+
+    Range range(const T &lo, const T &hi) const
+    {
+        if (hi < lo)
+            return Range(end(), end());
+        return Range(lower_bound(lo), lower_bound(hi));
+    }
+
+    void Insert(T value)
+    {
+        emplace(std::move(value));
+    }
+
+    // Builds the element in its node from args, equal elements allowed.
+    template <class... Args>
+    iterator emplace(Args &&...args)
+    {
+        NodeType *newNode = createNode(std::forward<Args>(args)...);
+        NodeType *parent = nullptr;
+        NodeType *current = root;
+        REDBLACKTREE_COUNT(searches, 1);
+
+        while (current != nullptr)
+        {
+            REDBLACKTREE_COUNT(comparisons, 1);
+            parent = current;
+            if (newNode->value < current->value)
+                current = current->left;
+            else
+                current = current->right;
+        }
+
+        linkNode(newNode, parent, parent != nullptr && newNode->value < parent->value);
+        return iterator(this, newNode);
+    }
+
+    // Builds an element from args only when nothing equal to key is in
+    // the tree yet; key must order like the element args would build.
+    // Returns the element with that key and whether it is new.
+    template <class Key, class... Args>
+    pair<iterator, bool> emplaceUnique(const Key &key, Args &&...args)
+    {
+        NodeType *parent = nullptr;
+        NodeType *current = root;
+        bool goLeft = false;
+        REDBLACKTREE_COUNT(searches, 1);
+
+        while (current != nullptr)
+        {
+            REDBLACKTREE_COUNT(comparisons, 1);
+            parent = current;
+            if (key < current->value)
+            {
+                goLeft = true;
+                current = current->left;
+            }
+            else if (current->value < key)
+            {
+                goLeft = false;
+                current = current->right;
+            }
+            else
+                return make_pair(iterator(this, current), false);
+        }
+
+        NodeType *newNode = createNode(std::forward<Args>(args)...);
+        linkNode(newNode, parent, goLeft);
+        return make_pair(iterator(this, newNode), true);
     }
 
     void Delete(T value)
     {
-        Node<T> *target = root;
-        Node<T> *replacement = nullptr;
-        bool targetOriginalColor = true;
+        NodeType *target = root;
+        REDBLACKTREE_COUNT(searches, 1);
 
         while (target != nullptr && target->value != value)
         {
+            REDBLACKTREE_COUNT(comparisons, 1);
             if (value < target->value)
                 target = target->left;
             else
@@ -284,42 +1230,267 @@ public:
             cout << "not found\n";
             return;
         }
+        removeNode(target);
+    }
 
-        targetOriginalColor = target->isRed;
+    // Removes one element equal to key; false if there is none.
+    template <class Key>
+    bool erase(const Key &key)
+    {
+        iterator it = find(key);
+        if (it == end())
+            return false;
+        removeNode(it.node);
+        return true;
+    }
 
-        if (target->left == nullptr)
+    // Replaces the contents with [first, last). Sorted input is built
+    // bottom-up into a balanced tree in O(n), in one block of nodes and on
+    // several threads for large inputs. Unsorted input falls back to Insert.
+    // Anything but random access input is copied once up front, since the
+    // sortedness check and the build each walk the range.
+    template <class Iterator>
+    void bulkLoad(Iterator first, Iterator last)
+    {
+        typedef typename iterator_traits<Iterator>::iterator_category Category;
+        if constexpr (!is_base_of<random_access_iterator_tag, Category>::value)
         {
-            replacement = target->right;
-            replaceNode(target, target->right);
+            vector<T> staged(first, last);
+            bulkLoad(staged.begin(), staged.end());
         }
-        else if (target->right == nullptr)
+        else
         {
-            replacement = target->left;
-            replaceNode(target, target->left);
+            destroyAll();
+            if (first == last)
+                return;
+
+            if (!is_sorted(first, last))
+            {
+                for (; first != last; ++first)
+                    Insert(*first);
+                return;
+            }
+            buildSorted(first, (size_t)(last - first));
         }
-        else
+    }
+
+    // Levels of nodes on the longest path, 0 for an empty tree. O(n).
+    int height() const
+    {
+        return subtreeHeight(root);
+    }
+
+    // Fewest levels any binary tree with size() nodes needs, ceil(log2(n + 1)).
+    int optimalHeight() const
+    {
+        int levels = 0;
+        while (((size_t)1 << levels) - 1 < size())
+            levels++;
+        return levels;
+    }
+
+    // Checks parent links, order, colors, black heights, the cached size
+    // and the augmentation of every node. For stress tests, O(n).
+    bool validate() const
+    {
+        if (isRedNode(root))
+            return false;
+        size_t count = 0;
+        if (validateSubtree(root, nullptr, count) < 0)
+            return false;
+        if (nodeCount != UnknownSize && nodeCount != count)
+            return false;
+        return is_sorted(begin(), end());
+    }
+
+#ifdef REDBLACKTREE_STATS
+    const RedBlackTreeStats &stats() const
+    {
+        return statistics;
+    }
+
+    void resetStats()
+    {
+        statistics = RedBlackTreeStats();
+    }
+
+    void printStats() const
+    {
+        cout << "rotations: " << statistics.rotations << ", recolors: " << statistics.recolors
+             << ", comparisons per search: " << (statistics.searches == 0 ? 0.0 : (double)statistics.comparisons / statistics.searches)
+             << ", height: " << height() << " (optimal " << optimalHeight() << ")"
+             << ", node bytes: " << statistics.allocatedBytes - statistics.freedBytes << " live, "
+             << statistics.allocatedBytes << " allocated" << endl;
+    }
+#endif
+
+    // Writes the elements in order as a SortedKeys snapshot.
+    bool save(const string &path) const
+    {
+        SnapshotWriter<T> writer(path, SortedKeys);
+        for (const T &value : *this)
+            writer.write(value);
+        return writer.close();
+    }
+
+    // Replaces the contents with a snapshot written by save(), through the
+    // O(n) bulk build straight from the mapped file. Leaves the tree as it
+    // was when the file cannot be used.
+    bool load(const string &path)
+    {
+        MappedSnapshot<T> snapshot(path, SortedKeys);
+        if (!snapshot.valid())
+            return false;
+        bulkLoad(snapshot.begin(), snapshot.end());
+        return true;
+    }
+
+    size_t size() const
+    {
+        if (nodeCount == UnknownSize)
         {
-            Node<T> *successor = getMinimum(target->right);
-            targetOriginalColor = successor->isRed;
-            replacement = successor->right;
+            if constexpr (is_same<Augmentation, SubtreeSize>::value)
+                nodeCount = SubtreeSize::sizeOf(root);
+            else
+                nodeCount = distance(begin(), end());
+        }
+        return nodeCount;
+    }
 
-            if (successor->parent != target)
+    bool empty() const
+    {
+        return root == nullptr;
+    }
+
+    // k-th smallest element, counting from 0; end() if k >= size().
+    iterator select(size_t k) const
+    {
+        static_assert(Augmentation::enabled && is_same<Augmentation, SubtreeSize>::value,
+                      "select needs the SubtreeSize augmentation");
+        NodeType *current = root;
+        while (current != nullptr)
+        {
+            size_t leftSize = SubtreeSize::sizeOf(current->left);
+            if (k < leftSize)
+                current = current->left;
+            else if (k == leftSize)
+                break;
+            else
             {
-                replaceNode(successor, successor->right);
-                successor->right = target->right;
-                if (successor->right != nullptr)
-                    successor->right->parent = successor;
+                k -= leftSize + 1;
+                current = current->right;
             }
+        }
+        return iterator(this, current);
+    }
 
-            replaceNode(target, successor);
-            successor->left = target->left;
-            if (successor->left != nullptr)
-                successor->left->parent = successor;
-            successor->isRed = target->isRed;
+    // Number of elements less than value.
+    size_t rank(const T &value) const
+    {
+        static_assert(Augmentation::enabled && is_same<Augmentation, SubtreeSize>::value,
+                      "rank needs the SubtreeSize augmentation");
+        size_t result = 0;
+        NodeType *current = root;
+        while (current != nullptr)
+        {
+            if (current->value < value)
+            {
+                result += SubtreeSize::sizeOf(current->left) + 1;
+                current = current->right;
+            }
+            else
+                current = current->left;
         }
+        return result;
+    }
+
+    // Number of elements in [lo, hi).
+    size_t count(const T &lo, const T &hi) const
+    {
+        if (hi < lo)
+            return 0;
+        return rank(hi) - rank(lo);
+    }
+
+    // Every interval that overlaps [lo, hi], in order. O(log n) per
+    // interval reported, plus O(log n) when there is none.
+    template <class Bound>
+    vector<T> overlapping(const Bound &lo, const Bound &hi) const
+    {
+        static_assert(is_same<Augmentation, IntervalMax>::value, "overlapping needs the IntervalMax augmentation");
+        vector<T> result;
+        if (!(hi < lo))
+            collectOverlapping(root, lo, hi, result);
+        return result;
+    }
+
+    // Every interval that contains point.
+    template <class Bound>
+    vector<T> stabbing(const Bound &point) const
+    {
+        return overlapping(point, point);
+    }
+
+    // Moves every element of greater into this tree. All elements of this
+    // tree must be less than all elements of greater. O(log n).
+    void join(RedBlackTree &greater)
+    {
+        if (&greater == this || greater.root == nullptr)
+            return;
+        size_t total = UnknownSize;
+        if (nodeCount != UnknownSize && greater.nodeCount != UnknownSize)
+            total = nodeCount + greater.nodeCount;
+        allocator.adopt(greater.allocator);
+        root = join2(root, greater.root);
+        root->isRed = false;
+        nodeCount = total;
+        greater.root = nullptr;
+        greater.nodeCount = 0;
+    }
+
+    // Moves the elements not less than key into greater, replacing what it
+    // held. O(log n); both trees keep using the memory of this one.
+    void split(const T &key, RedBlackTree &greater)
+    {
+        if (&greater == this)
+            return;
+        greater.clear();
+        NodeType *less;
+        NodeType *found;
+        NodeType *rest;
+        split(detach(root), key, less, found, rest);
+        if (found != nullptr)
+        {
+            found->parent = nullptr;
+            rest = join(nullptr, found, rest);
+        }
+        root = less;
+        greater.root = rest;
+        if (root != nullptr)
+            root->isRed = false;
+        if (greater.root != nullptr)
+            greater.root->isRed = false;
+        greater.allocator.share(allocator);
+        nodeCount = UnknownSize;
+        greater.nodeCount = UnknownSize;
+    }
 
-        if (!targetOriginalColor && replacement != nullptr)
-            FixDelete(replacement);
+    // Set operations, the elements of each tree must be distinct. other is
+    // left empty and its nodes are reused. O(m log(n/m + 1)) work, the two
+    // halves of each step run on WorkStealingPool::shared().
+    void unionWith(RedBlackTree &other)
+    {
+        combine<UnionOperation>(other);
+    }
+
+    void intersectWith(RedBlackTree &other)
+    {
+        combine<IntersectionOperation>(other);
+    }
+
+    void differenceWith(RedBlackTree &other)
+    {
+        combine<DifferenceOperation>(other);
     }
 
     void print()
@@ -327,6 +1498,148 @@ public:
         print(root);
     }
 };
+template <class T>
+using OrderStatisticTree = RedBlackTree<T, SlabAllocator, SubtreeSize>;
+
+template <class Bound>
+using IntervalTree = RedBlackTree<Interval<Bound>, SlabAllocator, IntervalMax>;
+
+// Element of RedBlackMap. Only first takes part in the ordering, so second
+// stays writable through the tree's const iterators.
+template <class K, class V, class Compare>
+struct MapEntry
+{
+    const K first;
+    mutable V second;
+
+    template <class KeyArg, class... Args>
+    MapEntry(KeyArg &&key, Args &&...args) : first(std::forward<KeyArg>(key)), second(std::forward<Args>(args)...)
+    {
+    }
+
+    friend bool operator<(const MapEntry &a, const MapEntry &b) { return Compare()(a.first, b.first); }
+
+    // Lookups by anything Compare accepts next to K.
+    template <class Key>
+    friend bool operator<(const MapEntry &a, const Key &b) { return Compare()(a.first, b); }
+    template <class Key>
+    friend bool operator<(const Key &a, const MapEntry &b) { return Compare()(a, b.first); }
+};
+
+// Ordered map on top of RedBlackTree. Entries are built in their node by
+// emplace/try_emplace, so neither keys nor values are copied and values
+// may be move-only. Compare is default constructed for every comparison;
+// when it declares is_transparent (like less<>), find/contains/erase
+// accept any key type it can compare, e.g. string_view for string keys.
+template <class K, class V, class Compare = less<K>>
+class RedBlackMap
+{
+    typedef MapEntry<K, V, Compare> Entry;
+    typedef RedBlackTree<Entry> Tree;
+
+    Tree tree;
+
+public:
+    typedef typename Tree::iterator iterator;
+    typedef iterator const_iterator;
+
+    RedBlackMap() {}
+    RedBlackMap(RedBlackMap &&) = default;
+    RedBlackMap &operator=(RedBlackMap &&) = default;
+
+    size_t size() const
+    {
+        return tree.size();
+    }
+
+    bool empty() const
+    {
+        return tree.empty();
+    }
+
+    void clear()
+    {
+        tree.clear();
+    }
+
+    iterator begin() const { return tree.begin(); }
+    iterator end() const { return tree.end(); }
+
+    // Builds the entry from key and args, unless key is already present.
+    template <class KeyArg, class... Args>
+    pair<iterator, bool> emplace(KeyArg &&key, Args &&...args)
+    {
+        return tree.emplaceUnique(key, std::forward<KeyArg>(key), std::forward<Args>(args)...);
+    }
+
+    // Like emplace, but args only build the value; nothing is constructed
+    // or moved from when key is already present.
+    template <class... Args>
+    pair<iterator, bool> try_emplace(const K &key, Args &&...args)
+    {
+        return tree.emplaceUnique(key, key, std::forward<Args>(args)...);
+    }
+
+    template <class... Args>
+    pair<iterator, bool> try_emplace(K &&key, Args &&...args)
+    {
+        return tree.emplaceUnique(key, std::move(key), std::forward<Args>(args)...);
+    }
+
+    V &operator[](const K &key)
+    {
+        return try_emplace(key).first->second;
+    }
+
+    V &operator[](K &&key)
+    {
+        return try_emplace(std::move(key)).first->second;
+    }
+
+    V &at(const K &key) const
+    {
+        iterator it = tree.find(key);
+        if (it == end())
+            throw out_of_range("Key is not in the map.");
+        return it->second;
+    }
+
+    iterator find(const K &key) const
+    {
+        return tree.find(key);
+    }
+
+    template <class Key, class C = Compare, class = typename C::is_transparent>
+    iterator find(const Key &key) const
+    {
+        return tree.find(key);
+    }
+
+    bool contains(const K &key) const
+    {
+        return tree.contains(key);
+    }
+
+    template <class Key, class C = Compare, class = typename C::is_transparent>
+    bool contains(const Key &key) const
+    {
+        return tree.contains(key);
+    }
+
+    // Returns false when key is not in the map.
+    bool erase(const K &key)
+    {
+        return tree.erase(key);
+    }
+
+    template <class Key, class C = Compare, class = typename C::is_transparent>
+    bool erase(const Key &key)
+    {
+        return tree.erase(key);
+    }
+};
+
+#ifndef NO_MAIN
 int main()
 {
     RedBlackTree<int> rbt;
@@ -344,5 +1657,53 @@ int main()
     rbt.Delete(0);
     rbt.print();
 
+    cout << "contains 555: " << (rbt.contains(555) ? "yes" : "no") << endl;
+    cout << "in order:";
+    for (int value : rbt)
+        cout << " " << value;
+    cout << endl;
+    cout << "range [100, 600):";
+    for (int value : rbt.range(100, 600))
+        cout << " " << value;
+    cout << endl;
+    OrderStatisticTree<int> ranked;
+    for (int value : {50, 10, 40, 20, 30})
+        ranked.Insert(value);
+    cout << "2nd smallest: " << *ranked.select(1) << ", keys below 35: " << ranked.rank(35)
+         << ", keys in [15, 45): " << ranked.count(15, 45) << endl;
+    IntervalTree<int> intervals;
+    for (Interval<int> interval : {Interval<int>{5, 10}, Interval<int>{15, 25}, Interval<int>{1, 3}, Interval<int>{8, 16}})
+        intervals.Insert(interval);
+    cout << "overlapping [9, 14]:";
+    for (const Interval<int> &interval : intervals.overlapping(9, 14))
+        cout << " " << interval;
+    cout << ", containing 16:";
+    for (const Interval<int> &interval : intervals.stabbing(16))
+        cout << " " << interval;
+    cout << endl;
+    RedBlackTree<int> loaded(vector<int>{1, 2, 3, 4, 5, 6, 7, 8, 9, 10});
+    loaded.print();
+    RedBlackTree<int> evens(vector<int>{2, 4, 6, 8, 10});
+    RedBlackTree<int> small(vector<int>{1, 2, 3, 4});
+    evens.unionWith(small);
+    cout << "union:";
+    for (int value : evens)
+        cout << " " << value;
+    cout << endl;
+    cout << "reverse:";
+    for (RedBlackTree<int>::iterator it = rbt.end(); it != rbt.begin();)
+        cout << " " << *--it;
+    cout << endl;
+
+    RedBlackMap<string, unique_ptr<int>, less<>> scores;
+    scores.try_emplace("alice", new int(10));
+    scores.try_emplace("bob", new int(7));
+    *scores["bob"] += 5;
+    cout << "alice: " << *scores.find(string_view("alice"))->second << ", bob: " << *scores.at("bob")
+         << ", has carol: " << (scores.contains(string_view("carol")) ? "yes" : "no") << endl;
+
     return 0;
 }
+#endif
+
+#endif
@@ -0,0 +1,380 @@
+#define NO_MAIN
+#define REDBLACKTREE_STATS
+#include <iostream>
+#include <algorithm>
+#include <cassert>
+#include <random>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "RedBlackTree.cpp"
+
+void testRandomInsertDelete() {
+    RedBlackTree<int> tree;
+    multiset<int> reference;
+    mt19937 gen(1);
+    for (int i = 0; i < 20000; i++) {
+        int value = gen() % 2000;
+        if (gen() % 3 != 0 || reference.empty()) {
+            tree.Insert(value);
+            reference.insert(value);
+        }
+        else {
+            int victim = *reference.lower_bound(value % (*reference.rbegin() + 1));
+            tree.Delete(victim);
+            reference.erase(reference.find(victim));
+        }
+        if (i % 500 == 0) {
+            assert(tree.validate());
+        }
+    }
+    assert(tree.validate());
+    assert(tree.size() == reference.size());
+    assert(equal(tree.begin(), tree.end(), reference.begin(), reference.end()));
+}
+
+void testDeleteEverything() {
+    RedBlackTree<int> tree;
+    for (int i = 0; i < 1000; i++) {
+        tree.Insert(i);
+    }
+    for (int i = 0; i < 1000; i += 2) {
+        tree.Delete(i);
+    }
+    assert(tree.validate());
+    for (int i = 1; i < 1000; i += 2) {
+        tree.Delete(i);
+    }
+    assert(tree.validate());
+    assert(tree.empty());
+}
+
+void testHeight() {
+    RedBlackTree<int> tree;
+    for (int i = 0; i < 100000; i++) {
+        tree.Insert(i);
+    }
+    assert(tree.optimalHeight() == 17);
+    assert(tree.height() >= tree.optimalHeight());
+    assert(tree.height() <= 2 * tree.optimalHeight());
+}
+
+void testStats() {
+    RedBlackTree<int> tree;
+    for (int i = 0; i < 1000; i++) {
+        tree.Insert(i);
+    }
+    const RedBlackTreeStats &stats = tree.stats();
+    assert(stats.rotations > 0);
+    assert(stats.recolors > 0);
+    assert(stats.searches > 0 && stats.comparisons >= stats.searches);
+    assert(stats.allocatedBytes == 1000 * sizeof(Node<int>));
+
+    tree.resetStats();
+    assert(tree.contains(500));
+    assert(tree.stats().searches == 1);
+    assert(tree.stats().comparisons <= (size_t)tree.height());
+    tree.Delete(500);
+    assert(tree.stats().freedBytes == sizeof(Node<int>));
+}
+
+// lower_bound, upper_bound and find agree with std::multiset for present
+// values, gaps between them and values past either end; duplicates sit
+// between the two bounds.
+void checkBounds(RedBlackTree<int> &tree, const multiset<int> &reference, int low, int high) {
+    for (int value = low; value <= high; value++) {
+        auto lower = tree.lower_bound(value);
+        auto expectedLower = reference.lower_bound(value);
+        assert((lower == tree.end()) == (expectedLower == reference.end()));
+        assert(lower == tree.end() || *lower == *expectedLower);
+        auto upper = tree.upper_bound(value);
+        auto expectedUpper = reference.upper_bound(value);
+        assert((upper == tree.end()) == (expectedUpper == reference.end()));
+        assert(upper == tree.end() || *upper == *expectedUpper);
+        assert((size_t)distance(lower, upper) == reference.count(value));
+        auto found = tree.find(value);
+        assert((found == tree.end()) == (reference.count(value) == 0));
+        assert(found == tree.end() || *found == value);
+    }
+}
+
+// Walking back from end() sees the forward walk reversed.
+void checkReverse(RedBlackTree<int> &tree) {
+    vector<int> forward(tree.begin(), tree.end());
+    vector<int> backward(make_reverse_iterator(tree.end()), make_reverse_iterator(tree.begin()));
+    assert(equal(forward.rbegin(), forward.rend(), backward.begin(), backward.end()));
+    vector<int> stepped;
+    for (auto it = tree.end(); it != tree.begin();) {
+        --it;
+        stepped.push_back(*it);
+    }
+    assert(stepped == backward);
+}
+
+void testBoundsAndIterators() {
+    RedBlackTree<int> tree;
+    multiset<int> reference;
+    assert(tree.begin() == tree.end());
+    checkBounds(tree, reference, -2, 2);
+
+    mt19937 gen(3);
+    for (int i = 0; i < 3000; i++) {
+        int value = 3 * (gen() % 1000);
+        tree.Insert(value);
+        reference.insert(value);
+    }
+    checkReverse(tree);
+    checkBounds(tree, reference, -5, 3005);
+
+    for (int round = 0; round < 10; round++) {
+        tree.Delete(*tree.begin());
+        reference.erase(reference.begin());
+        tree.Delete(*--tree.end());
+        reference.erase(prev(reference.end()));
+        for (int i = 0; i < 100; i++) {
+            int value = 3 * (gen() % 1000);
+            if (reference.count(value)) {
+                tree.Delete(value);
+                reference.erase(reference.find(value));
+            }
+        }
+        assert(tree.validate());
+        checkReverse(tree);
+        checkBounds(tree, reference, -5, 3005);
+    }
+
+    for (int i = 0; i < 1000; i++) {
+        int lo = (int)(gen() % 3010) - 5;
+        int hi = (int)(gen() % 3010) - 5;
+        auto range = tree.range(lo, hi);
+        if (hi < lo) {
+            assert(range.empty());
+            continue;
+        }
+        assert(equal(range.begin(), range.end(), reference.lower_bound(lo), reference.lower_bound(hi)));
+    }
+}
+
+// select, rank and count agree with the sorted reference: select for
+// every index, rank of every value in [low, high] present or not, and
+// count over random ranges.
+void checkRanks(OrderStatisticTree<int> &tree, const multiset<int> &reference, int low, int high, mt19937 &gen) {
+    vector<int> sorted(reference.begin(), reference.end());
+    assert(tree.size() == sorted.size());
+    assert(tree.select(sorted.size()) == tree.end());
+    for (size_t i = 0; i < sorted.size(); i++) {
+        assert(*tree.select(i) == sorted[i]);
+    }
+    for (int value = low; value <= high; value++) {
+        size_t expected = lower_bound(sorted.begin(), sorted.end(), value) - sorted.begin();
+        assert(tree.rank(value) == expected);
+    }
+    for (int i = 0; i < 1000; i++) {
+        int lo = low + (int)(gen() % (high - low + 1));
+        int hi = low + (int)(gen() % (high - low + 1));
+        size_t expected = 0;
+        if (lo <= hi) {
+            expected = lower_bound(sorted.begin(), sorted.end(), hi) - lower_bound(sorted.begin(), sorted.end(), lo);
+        }
+        assert(tree.count(lo, hi) == expected);
+    }
+}
+
+// overlapping and stabbing agree with a scan of the sorted reference.
+void checkOverlaps(IntervalTree<int> &tree, vector<Interval<int>> reference, int lo, int hi) {
+    sort(reference.begin(), reference.end());
+    vector<Interval<int>> expected;
+    for (const Interval<int> &interval : reference) {
+        if (lo <= hi && interval.overlaps(lo, hi)) {
+            expected.push_back(interval);
+        }
+    }
+    assert(tree.overlapping(lo, hi) == expected);
+    if (lo == hi) {
+        assert(tree.stabbing(lo) == expected);
+    }
+}
+
+void testIntervalQueries() {
+    IntervalTree<int> tree;
+    vector<Interval<int>> reference;
+    mt19937 gen(5);
+    for (int i = 0; i < 3000; i++) {
+        int lo = gen() % 1000;
+        Interval<int> interval{lo, lo + (int)(gen() % 50)};
+        tree.Insert(interval);
+        reference.push_back(interval);
+        if (i % 3 == 0) {
+            size_t victim = gen() % reference.size();
+            tree.Delete(reference[victim]);
+            reference.erase(reference.begin() + victim);
+        }
+    }
+    assert(tree.validate());
+
+    // Every point, which includes every endpoint and the gaps around them.
+    for (int point = -2; point <= 1052; point++) {
+        checkOverlaps(tree, reference, point, point);
+    }
+    // Ranges that start or end exactly on an endpoint, and empty ones.
+    for (int i = 0; i < 300; i++) {
+        const Interval<int> &a = reference[gen() % reference.size()];
+        const Interval<int> &b = reference[gen() % reference.size()];
+        checkOverlaps(tree, reference, a.lo, b.hi);
+        checkOverlaps(tree, reference, a.hi, b.lo);
+        checkOverlaps(tree, reference, a.hi + 1, a.hi + 1 + (int)(gen() % 100));
+    }
+}
+
+void testAugmentedTrees() {
+    OrderStatisticTree<int> ranked;
+    multiset<int> rankedReference;
+    IntervalTree<int> intervals;
+    mt19937 gen(2);
+    for (int i = 0; i < 5000; i++) {
+        int value = gen() % 1000;
+        ranked.Insert(value);
+        rankedReference.insert(value);
+        intervals.Insert(Interval<int>{value, value + (int)(gen() % 50)});
+        if (i % 3 == 0) {
+            int victim = *ranked.select(gen() % ranked.size());
+            ranked.Delete(victim);
+            rankedReference.erase(rankedReference.find(victim));
+        }
+        if (i % 1000 == 0) {
+            checkRanks(ranked, rankedReference, -2, 1002, gen);
+        }
+    }
+    assert(ranked.validate());
+    checkRanks(ranked, rankedReference, -2, 1002, gen);
+    assert(intervals.validate());
+}
+
+// Every set operation, split and join give exactly what the std
+// algorithms give on the sorted inputs.
+void checkSetOperations(const vector<int> &x, const vector<int> &y, int key) {
+    vector<int> expected;
+    set_union(x.begin(), x.end(), y.begin(), y.end(), back_inserter(expected));
+    RedBlackTree<int> a(x);
+    RedBlackTree<int> b(y);
+    a.unionWith(b);
+    assert(a.validate() && b.empty());
+    assert(a.size() == expected.size() && equal(a.begin(), a.end(), expected.begin(), expected.end()));
+
+    // Both halves of the split, then joined back together.
+    RedBlackTree<int> greater;
+    greater.Insert(-1);
+    a.split(key, greater);
+    auto middle = lower_bound(expected.begin(), expected.end(), key);
+    assert(a.validate() && greater.validate());
+    assert(equal(a.begin(), a.end(), expected.begin(), middle));
+    assert(equal(greater.begin(), greater.end(), middle, expected.end()));
+    assert(a.size() == (size_t)(middle - expected.begin()) && greater.size() == (size_t)(expected.end() - middle));
+    a.join(greater);
+    assert(a.validate() && greater.empty());
+    assert(equal(a.begin(), a.end(), expected.begin(), expected.end()));
+
+    expected.clear();
+    set_intersection(x.begin(), x.end(), y.begin(), y.end(), back_inserter(expected));
+    RedBlackTree<int> c(x);
+    RedBlackTree<int> d(y);
+    c.intersectWith(d);
+    assert(c.validate() && d.empty());
+    assert(c.size() == expected.size() && equal(c.begin(), c.end(), expected.begin(), expected.end()));
+
+    expected.clear();
+    set_difference(x.begin(), x.end(), y.begin(), y.end(), back_inserter(expected));
+    RedBlackTree<int> e(x);
+    RedBlackTree<int> f(y);
+    e.differenceWith(f);
+    assert(e.validate() && f.empty());
+    assert(e.size() == expected.size() && equal(e.begin(), e.end(), expected.begin(), expected.end()));
+}
+
+void testBulkAndSetOperations() {
+    // Large enough for forkJoin to hand halves to the pool.
+    vector<int> evens;
+    vector<int> threes;
+    for (int i = 0; i < 100000; i++) {
+        evens.push_back(i * 2);
+        threes.push_back(i * 3);
+    }
+    checkSetOperations(evens, threes, 150000);
+    checkSetOperations(threes, evens, 150000);
+
+    // Small random sets, disjoint and empty ones, and splits at the ends.
+    mt19937 gen(4);
+    for (int round = 0; round < 50; round++) {
+        set<int> x;
+        set<int> y;
+        int xSize = gen() % 200;
+        int ySize = gen() % 200;
+        for (int i = 0; i < xSize; i++) {
+            x.insert(gen() % 500);
+        }
+        for (int i = 0; i < ySize; i++) {
+            y.insert(round % 5 == 0 ? 500 + gen() % 500 : gen() % 500);
+        }
+        int key = (int)(gen() % 1100) - 50;
+        checkSetOperations(vector<int>(x.begin(), x.end()), vector<int>(y.begin(), y.end()), key);
+    }
+    checkSetOperations(vector<int>(), vector<int>{1, 2, 3}, 2);
+    checkSetOperations(vector<int>{1, 2, 3}, vector<int>(), 2);
+}
+
+void testBulkLoadFromStream() {
+    istringstream sorted("1 2 3 5 8 13 21");
+    RedBlackTree<int> tree;
+    tree.bulkLoad(istream_iterator<int>(sorted), istream_iterator<int>());
+    assert(tree.validate());
+    assert(tree.size() == 7 && tree.contains(13) && !tree.contains(4));
+
+    istringstream unsorted("9 4 7 4 1");
+    tree.bulkLoad(istream_iterator<int>(unsorted), istream_iterator<int>());
+    assert(tree.validate());
+    vector<int> expected = {1, 4, 4, 7, 9};
+    assert(equal(tree.begin(), tree.end(), expected.begin(), expected.end()));
+}
+
+void testMapAndMoves() {
+    RedBlackMap<string, unique_ptr<int>, less<>> map;
+    assert(map.try_emplace("b", new int(2)).second);
+    assert(map.emplace(string("a"), new int(1)).second);
+    unique_ptr<int> spare(new int(3));
+    assert(!map.try_emplace("a", std::move(spare)).second);
+    assert(spare && *spare == 3);
+    assert(*map.find(string_view("b"))->second == 2);
+    map["c"].reset(new int(4));
+    assert(map.size() == 3 && *map.at("c") == 4);
+    assert(map.erase(string_view("a")) && !map.contains(string_view("a")));
+
+    RedBlackMap<string, unique_ptr<int>, less<>> moved(std::move(map));
+    assert(moved.size() == 2 && map.empty());
+    map = std::move(moved);
+    assert(map.size() == 2 && moved.empty());
+
+    RedBlackTree<int> tree;
+    for (int i = 0; i < 100; i++) {
+        tree.Insert(i);
+    }
+    RedBlackTree<int> other(std::move(tree));
+    tree = std::move(other);
+    assert(tree.size() == 100 && other.empty());
+    assert(tree.validate());
+}
+
+int main() {
+    testRandomInsertDelete();
+    testDeleteEverything();
+    testHeight();
+    testStats();
+    testBoundsAndIterators();
+    testAugmentedTrees();
+    testIntervalQueries();
+    testBulkAndSetOperations();
+    testBulkLoadFromStream();
+    testMapAndMoves();
+    std::cout << "All tests passed!" << std::endl;
+    return 0;
+}
@@ -1,307 +1,458 @@
+#ifndef SKIPLIST_CPP
+#define SKIPLIST_CPP
+
 #include <iostream>
-#include <random>
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
 #include <string>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "HashTable.cpp"
+#include "NodeAllocator.cpp"
+#include "SkipListLevels.cpp"
+#include "Snapshot.cpp"
 using namespace std;
 
+// A node and its forward pointers share one block: the tower follows the
+// node in memory, so next(level) needs no extra load. Behind the pointers
+// sits the span of every link, the number of bottom level steps it skips;
+// a link to nullptr spans to one past the last element. The bottom level
+// is also linked backwards; the first node's backward link is nullptr.
+// Nodes are made and freed through create/destroy with the list's
+// size-class allocator.
 template <typename T>
 class SkipListNode
 {
 private:
     int levelCount;
-    SkipListNode<T> **forward;
+    SkipListNode<T> *backward = nullptr;
+    static size_t towerOffset()
+    {
+        const size_t pointerAlign = alignof(SkipListNode<T> *);
+        return (sizeof(SkipListNode<T>) + pointerAlign - 1) / pointerAlign * pointerAlign;
+    }
+    SkipListNode<T> **forward()
+    {
+        return reinterpret_cast<SkipListNode<T> **>(reinterpret_cast<char *>(this) + towerOffset());
+    }
+    SkipListNode<T> *const *forward() const
+    {
+        return reinterpret_cast<SkipListNode<T> *const *>(reinterpret_cast<const char *>(this) + towerOffset());
+    }
+    int *spans()
+    {
+        return reinterpret_cast<int *>(forward() + levelCount);
+    }
+    const int *spans() const
+    {
+        return reinterpret_cast<const int *>(forward() + levelCount);
+    }
+    static size_t allocationSize(int levelCount)
+    {
+        return towerOffset() + levelCount * (sizeof(SkipListNode<T> *) + sizeof(int));
+    }
+    SkipListNode(const T &value, int levelCount) : levelCount(levelCount), value(value)
+    {
+        for (int level = 0; level < levelCount; level++)
+        {
+            forward()[level] = nullptr;
+            spans()[level] = 1;
+        }
+    }
 
 public:
     T value;
-    int getLevelCount() const
+    SkipListNode(const SkipListNode &) = delete;
+    SkipListNode &operator=(const SkipListNode &) = delete;
+    template <typename Allocator>
+    static SkipListNode<T> *create(Allocator &allocator, const T &value, int levelCount)
     {
-        return levelCount;
+        return new (allocator.allocate(allocationSize(levelCount))) SkipListNode<T>(value, levelCount);
     }
-    SkipListNode(T value, int levelCount)
+    template <typename Allocator>
+    static void destroy(Allocator &allocator, SkipListNode<T> *node)
     {
-        forward = new SkipListNode<T> *[levelCount];
-        this->levelCount = levelCount;
-        this->value = value;
+        size_t bytes = allocationSize(node->levelCount);
+        node->~SkipListNode<T>();
+        allocator.deallocate(node, bytes);
     }
+    int getLevelCount() const
+    {
+        return levelCount;
+    }
+    // Levels are only range checked in debug builds.
     SkipListNode<T> *next(int level = 0) const
     {
+#ifndef NDEBUG
         if (level < 0 || level >= levelCount)
         {
             throw out_of_range("Level is out of valid range.");
         }
-        return forward[level];
+#endif
+        return forward()[level];
     }
     void insertAfter(SkipListNode<T> *newNode, int level)
     {
+#ifndef NDEBUG
         if (level < 0 || level >= levelCount || level >= newNode->levelCount)
         {
             throw out_of_range("Level is out of valid range.");
         }
-        newNode->forward[level] = forward[level];
-        forward[level] = newNode;
+#endif
+        newNode->forward()[level] = forward()[level];
+        forward()[level] = newNode;
     }
     void setNext(SkipListNode<T> *next, int level)
     {
+#ifndef NDEBUG
         if (level < 0 || level >= levelCount)
         {
             throw out_of_range("Level is out of valid range.");
         }
-        forward[level] = next;
+#endif
+        forward()[level] = next;
     }
-    operator T() const
+    SkipListNode<T> *prev() const
     {
-        return value;
+        return backward;
+    }
+    void setPrev(SkipListNode<T> *prev)
+    {
+        backward = prev;
+    }
+    int span(int level = 0) const
+    {
+#ifndef NDEBUG
+        if (level < 0 || level >= levelCount)
+        {
+            throw out_of_range("Level is out of valid range.");
+        }
+#endif
+        return spans()[level];
+    }
+    void setSpan(int span, int level)
+    {
+#ifndef NDEBUG
+        if (level < 0 || level >= levelCount)
+        {
+            throw out_of_range("Level is out of valid range.");
+        }
+#endif
+        spans()[level] = span;
     }
-    ~SkipListNode()
+    operator T() const
     {
-        delete[] forward;
+        return value;
     }
 };
+// Walks the bottom level in both directions; end() steps back to the
+// list's tail.
 template <typename T>
-struct SkipListHeadNode
+class SkipListIterator
 {
-    SkipListNode<T> *node = nullptr;
-    SkipListHeadNode<T> *nextLevelHead = nullptr;
-    SkipListHeadNode<T> *prevLevelHead = nullptr;
+    const SkipListNode<T> *node;
+    SkipListNode<T> *const *tail;
+
+public:
+    typedef bidirectional_iterator_tag iterator_category;
+    typedef T value_type;
+    typedef ptrdiff_t difference_type;
+    typedef const T *pointer;
+    typedef const T &reference;
+
+    SkipListIterator(const SkipListNode<T> *node = nullptr, SkipListNode<T> *const *tail = nullptr)
+        : node(node), tail(tail) {}
+    const SkipListNode<T> *getNode() const
+    {
+        return node;
+    }
+    reference operator*() const
+    {
+        return node->value;
+    }
+    pointer operator->() const
+    {
+        return &node->value;
+    }
+    SkipListIterator &operator++()
+    {
+        node = node->next();
+        return *this;
+    }
+    SkipListIterator operator++(int)
+    {
+        SkipListIterator previous = *this;
+        ++*this;
+        return previous;
+    }
+    SkipListIterator &operator--()
+    {
+        node = node ? node->prev() : *tail;
+        return *this;
+    }
+    SkipListIterator operator--(int)
+    {
+        SkipListIterator previous = *this;
+        --*this;
+        return previous;
+    }
+    bool operator==(const SkipListIterator &other) const
+    {
+        return node == other.node;
+    }
+    bool operator!=(const SkipListIterator &other) const
+    {
+        return node != other.node;
+    }
 };
+// Walks one level of the list forwards.
 template <typename T>
-class SkipListHead
+class SkipListLevelIterator
 {
-    int levelCount = 1;
-    SkipListHeadNode<T> *head;
-    SkipListHeadNode<T> *last;
-    void addLevel()
+    const SkipListNode<T> *node;
+    int level;
+
+public:
+    typedef forward_iterator_tag iterator_category;
+    typedef T value_type;
+    typedef ptrdiff_t difference_type;
+    typedef const T *pointer;
+    typedef const T &reference;
+
+    SkipListLevelIterator(const SkipListNode<T> *node = nullptr, int level = 0) : node(node), level(level) {}
+    reference operator*() const
     {
-        levelCount++;
-        last->nextLevelHead = new SkipListHeadNode<T>();
-        last->nextLevelHead->prevLevelHead = last;
-        last = last->nextLevelHead;
+        return node->value;
     }
-    SkipListHeadNode<T> *getLevel(int level)
+    pointer operator->() const
     {
-        if (level >= levelCount || level < 0)
-        {
-            throw out_of_range("Level is out of valid range.");
-        }
-        int currentLevel = 0;
-        SkipListHeadNode<T> *current = head;
-        while (currentLevel < level)
-        {
-            currentLevel++;
-            current = current->nextLevelHead;
-        }
-        return current;
+        return &node->value;
     }
-    void ensureLevelExist(int level)
+    SkipListLevelIterator &operator++()
     {
-        while (this->levelCount <= level)
-        {
-            addLevel();
-        }
+        node = node->next(level);
+        return *this;
     }
+    SkipListLevelIterator operator++(int)
+    {
+        SkipListLevelIterator previous = *this;
+        ++*this;
+        return previous;
+    }
+    bool operator==(const SkipListLevelIterator &other) const
+    {
+        return node == other.node;
+    }
+    bool operator!=(const SkipListLevelIterator &other) const
+    {
+        return node != other.node;
+    }
+};
+// Half-open slice of a list, usable in a range-for.
+template <typename Iterator>
+class SkipListRange
+{
+    Iterator first;
+    Iterator last;
 
 public:
-    int getLevelCount() const
+    SkipListRange(Iterator first, Iterator last) : first(first), last(last) {}
+    Iterator begin() const
     {
-        return levelCount;
+        return first;
     }
-    SkipListHeadNode<T> *getFirstLevelHead() const
+    Iterator end() const
     {
-        return head;
+        return last;
     }
-    SkipListHeadNode<T> *getLastLevelHead() const
+    bool empty() const
     {
-        return last;
+        return first == last;
     }
-    SkipListHeadNode<T> *insertToHead(SkipListNode<T> *node, int &level)
+};
+// LevelGenerator picks tower heights, see SkipListLevels.cpp; pass one with
+// a fixed seed for reproducible runs.
+template <typename T, class LevelGenerator = HalfLevels>
+class SkipList
+{
+private:
+    // Towers never grow past this, so the head sentinel can carry all levels.
+    static const int MaxLevel = SkipListMaxLevel;
+    int count = 0;
+    int levelCount = 1;
+    SizeClassAllocator<alignof(SkipListNode<T>)> pool;
+    // Sentinel in front of the first node on every level; its value is never
+    // compared, so every search starts at head without special cases.
+    SkipListNode<T> *head;
+    SkipListNode<T> *tail = nullptr;
+    LevelGenerator levels;
+    int getRandomLevelCount()
     {
-        level = node->getLevelCount() - 1;
-        ensureLevelExist(level);
-        SkipListHeadNode<T> *h = getLevel(level);
-        while (h && (!h->node || h->node->value > node->value))
-        {
-            node->setNext(h->node, level);
-            h->node = node;
-            level--;
-            h = h->prevLevelHead;
-        }
-        return h;
+        return levels.next();
     }
-    SkipListHeadNode<T> *getSearchHead(T value, int &level, bool printPath = false) const
+    void destroyNodes()
     {
-        level = levelCount - 1;
-        SkipListHeadNode<T> *searchHead = last;
-        while (searchHead && (!searchHead->node || searchHead->node->value > value))
+        SkipListNode<T> *node = head->next();
+        while (node)
         {
-            if (printPath)
-            {
-                cout << "Level: " << level << ", next: ";
-                if (searchHead->node)
-                {
-                    cout << *(searchHead->node) << endl;
-                }
-                else
-                {
-                    cout << "Null" << endl;
-                }
-            }
-
-            level--;
-            searchHead = searchHead->prevLevelHead;
+            SkipListNode<T> *temp = node->next();
+            SkipListNode<T>::destroy(pool, node);
+            node = temp;
         }
-        return searchHead;
+        detachNodes();
     }
-    SkipListHeadNode<T> *removeFromHead(T value, int &searchLevel, SkipListNode<T> **deletedNode)
+    // Empties the list without touching the nodes, which the caller owns.
+    void detachNodes()
     {
-        SkipListHeadNode<T> *searchHead = getSearchHead(value, searchLevel);
-        *deletedNode = nullptr;
-        while (searchHead && searchHead->node && searchHead->node->value == value)
+        for (int level = 0; level < levelCount; level++)
         {
-            *deletedNode = searchHead->node;
-            searchHead->node = searchHead->node->next(searchLevel);
-            (*deletedNode)->setNext(nullptr, searchLevel);
-            searchLevel--;
-            searchHead = searchHead->prevLevelHead;
+            head->setNext(nullptr, level);
+            head->setSpan(1, level);
         }
-        return searchHead;
+        tail = nullptr;
+        levelCount = 1;
+        count = 0;
     }
-    SkipListHead()
+    void trimLevels()
     {
-        head = new SkipListHeadNode<T>();
-        last = head;
+        while (levelCount > 1 && !head->next(levelCount - 1))
+        {
+            levelCount--;
+        }
     }
-    ~SkipListHead()
+    // Left to right build of an empty list: tails holds the last node of
+    // every level and tailRanks its position. Nodes go in ascending order,
+    // finishAppend() then closes every level.
+    void appendNode(SkipListNode<T> *node, vector<SkipListNode<T> *> &tails, vector<int> &tailRanks)
     {
-        SkipListHeadNode<T> *current = head;
-        while (current)
+        count++;
+        node->setPrev(tails[0] == head ? nullptr : tails[0]);
+        for (int level = 0; level < node->getLevelCount(); level++)
+        {
+            tails[level]->setNext(node, level);
+            tails[level]->setSpan(count - tailRanks[level], level);
+            tails[level] = node;
+            tailRanks[level] = count;
+        }
+        if (node->getLevelCount() > levelCount)
         {
-            SkipListHeadNode<T> *temp = current->nextLevelHead;
-            delete current;
-            current = temp;
+            levelCount = node->getLevelCount();
         }
     }
-};
-
-template <typename T>
-class SkipList
-{
-private:
-    int count = 0;
-    SkipListHead<T> head;
-    random_device rd;
-    mt19937 gen;
-    uniform_int_distribution<> distr;
-    bool shouldGoUp()
+    void finishAppend(vector<SkipListNode<T> *> &tails, vector<int> &tailRanks)
     {
-        return distr(gen) > 500;
+        for (int level = 0; level < levelCount; level++)
+        {
+            tails[level]->setNext(nullptr, level);
+            tails[level]->setSpan(count + 1 - tailRanks[level], level);
+        }
+        tail = tails[0] == head ? nullptr : tails[0];
     }
-    int getRandomLevelCount()
+    // One descent from head: update[level] ends up as the last node before
+    // value on each level in use and rank[level] as its position, counting
+    // head as 0. Returns the first node not less than value.
+    SkipListNode<T> *descend(const T &value, SkipListNode<T> **update, int *rank) const
     {
-        int levelCount = 1;
-        while (shouldGoUp())
+        SkipListNode<T> *searchNode = head;
+        int position = 0;
+        for (int level = levelCount - 1; level >= 0; level--)
         {
-            levelCount++;
+            SkipListNode<T> *next = searchNode->next(level);
+            while (next && next->value < value)
+            {
+                position += searchNode->span(level);
+                searchNode = next;
+                next = searchNode->next(level);
+            }
+            update[level] = searchNode;
+            rank[level] = position;
         }
-        return levelCount;
+        return searchNode->next();
+    }
+    SkipListIterator<T> makeIterator(const SkipListNode<T> *node) const
+    {
+        return SkipListIterator<T>(node, &tail);
     }
 
 public:
+    typedef SkipListIterator<T> iterator;
+    typedef std::reverse_iterator<iterator> reverse_iterator;
+    typedef SkipListRange<iterator> Range;
+    typedef SkipListRange<SkipListLevelIterator<T>> LevelRange;
+
     int getCount() const
     {
         return count;
     }
     bool remove(T value)
     {
-        int searchLevel;
-        SkipListNode<T> *deletedNode = nullptr;
-        SkipListHeadNode<T> *searchHead = head.removeFromHead(value, searchLevel, &deletedNode);
-        SkipListNode<T> *searchNode = searchHead ? searchHead->node : nullptr;
-        while (searchNode && searchLevel >= 0)
+        SkipListNode<T> *update[MaxLevel];
+        int rank[MaxLevel];
+        SkipListNode<T> *deletedNode = descend(value, update, rank);
+        if (!deletedNode || !(deletedNode->value == value))
         {
-            SkipListNode<T> *nextNode = searchNode->next(searchLevel);
-            if (nextNode && nextNode->value == value)
-            {
-
-                deletedNode = nextNode;
-                searchNode->setNext(nextNode->next(searchLevel), searchLevel);
-                deletedNode->setNext(nullptr, searchLevel);
-                searchLevel--;
-            }
-
-            else if (nextNode && nextNode->value < value)
+            return false;
+        }
+        for (int level = 0; level < levelCount; level++)
+        {
+            if (level < deletedNode->getLevelCount())
             {
-                searchNode = nextNode;
+                update[level]->setSpan(update[level]->span(level) + deletedNode->span(level) - 1, level);
+                update[level]->setNext(deletedNode->next(level), level);
             }
-
             else
             {
-                searchLevel--;
+                update[level]->setSpan(update[level]->span(level) - 1, level);
             }
         }
-
-        if (deletedNode)
+        if (deletedNode->next())
         {
-
-            count--;
-            delete deletedNode;
-            return true;
+            deletedNode->next()->setPrev(deletedNode->prev());
         }
-        return false;
+        else
+        {
+            tail = deletedNode->prev();
+        }
+        count--;
+        SkipListNode<T>::destroy(pool, deletedNode);
+        trimLevels();
+        return true;
     }
     const SkipListNode<T> *find(T value, bool printPath = false) const
     {
-        int searchLevel;
-        SkipListHeadNode<T> *searchHead = head.getSearchHead(value, searchLevel, printPath);
-        if (!searchHead || searchLevel < 0)
+        const SkipListNode<T> *searchNode = head;
+        for (int level = levelCount - 1; level >= 0; level--)
         {
-            return nullptr;
-        }
-        SkipListNode<T> *searchNode = searchHead->node;
-        while (searchNode && searchLevel >= 0)
-        {
-
-            const int maxSearchLevel = searchNode->getLevelCount() - 1;
-            searchLevel = maxSearchLevel < searchLevel ? maxSearchLevel : searchLevel;
-            SkipListNode<T> *next = searchNode->next(searchLevel);
+            SkipListNode<T> *next = searchNode->next(level);
+            while (next && next->value < value)
+            {
+                searchNode = next;
+                if (printPath)
+                {
+                    cout << "Level: " << level << ", visiting: " << *searchNode << endl;
+                }
+                next = searchNode->next(level);
+            }
             if (printPath)
             {
-                cout << "Level: " << searchLevel << ", visiting: " << *searchNode << endl;
-                cout << "Level: " << searchLevel << ", next: ";
                 if (next)
                 {
-                    cout << *next << endl;
+                    cout << "Level: " << level << ", next: " << *next << endl;
                 }
                 else
                 {
-                    cout << "Null" << endl;
+                    cout << "Level: " << level << ", next: Null" << endl;
                 }
             }
-            if (searchNode->value == value)
-            {
-                return searchNode;
-            }
-            else if (searchLevel == 0 && next && next->value > value)
+            if (next && next->value == value)
             {
-                return nullptr;
+                return next;
             }
-            while ((searchLevel > 0) && (!next || next->value > value))
-            {
-                searchLevel--;
-                next = searchNode->next(searchLevel);
-                if (printPath)
-                {
-                    if (next)
-                    {
-                        cout << "Level: " << searchLevel << ", next: " << *next << endl;
-                    }
-                    else
-                    {
-                        cout << "Level: " << searchLevel << ", next: Null" << endl;
-                    }
-                }
-            }
-            searchNode = next;
         }
-
         return nullptr;
     }
     void printPathTo(T value) const
@@ -318,37 +469,51 @@ public:
         }
     }
 
-    SkipListNode<T> *insert(T value)
+    // Adds value unless an equal one is present; returns the element with
+    // that value and whether it was inserted.
+    pair<iterator, bool> insert(T value)
     {
-        if (find(value))
+        SkipListNode<T> *update[MaxLevel];
+        int rank[MaxLevel];
+        SkipListNode<T> *next = descend(value, update, rank);
+        if (next && next->value == value)
         {
-            return nullptr;
+            return make_pair(makeIterator(next), false);
         }
 
-        count++;
-        const int levelCount = getRandomLevelCount();
-        int level = levelCount - 1;
-        SkipListNode<T> *node = new SkipListNode<T>(value, levelCount);
-        SkipListHeadNode<T> *insertionHead = head.insertToHead(node, level);
-        if (!insertionHead)
+        const int nodeLevelCount = getRandomLevelCount();
+        for (; levelCount < nodeLevelCount; levelCount++)
         {
-            return node;
+            update[levelCount] = head;
+            rank[levelCount] = 0;
+            head->setSpan(count + 1, levelCount);
         }
-        SkipListNode<T> *searchNode = insertionHead->node;
-        while (searchNode && (level >= 0))
+        count++;
+        SkipListNode<T> *node = SkipListNode<T>::create(pool, value, nodeLevelCount);
+        for (int level = 0; level < levelCount; level++)
         {
-            while (searchNode->next(level) && searchNode->next(level)->value <= value)
+            if (level < nodeLevelCount)
             {
-                searchNode = searchNode->next(level);
+                const int stepsBefore = rank[0] - rank[level];
+                update[level]->insertAfter(node, level);
+                node->setSpan(update[level]->span(level) - stepsBefore, level);
+                update[level]->setSpan(stepsBefore + 1, level);
             }
-
-            while ((level >= 0) && (!searchNode->next(level) || searchNode->next(level)->value > value))
+            else
             {
-                searchNode->insertAfter(node, level);
-                level--;
+                update[level]->setSpan(update[level]->span(level) + 1, level);
             }
         }
-        return node;
+        node->setPrev(update[0] == head ? nullptr : update[0]);
+        if (node->next())
+        {
+            node->next()->setPrev(node);
+        }
+        else
+        {
+            tail = node;
+        }
+        return make_pair(makeIterator(node), true);
     }
     void printFullList() const
     {
@@ -359,75 +524,331 @@ public:
             return;
         }
         cout << "Skip list has: " << endl;
-        cout << head.getLevelCount() << " levels" << endl;
+        cout << levelCount << " levels" << endl;
         cout << count << " items" << endl
              << endl;
-        SkipListHeadNode<T> *currentHead = head.getLastLevelHead();
-        int level = head.getLevelCount() - 1;
 
-        while (currentHead)
+        for (int level = levelCount - 1; level >= 0; level--)
         {
             cout << "Level " << level << ": ";
-
-            SkipListNode<T> *node = currentHead->node;
-
-            while (node)
+            for (const T &value : levelItems(level))
             {
-                cout << *node << " ";
-                node = node->next(level); // Move to the next node at this level
+                cout << value << " ";
             }
-
             cout << endl;
-
-            // Move to the next lower level
-            currentHead = currentHead->prevLevelHead;
-            level--;
         }
         cout << endl;
     }
     void printItems() const
     {
         cout << "List: ";
-        SkipListNode<T> *node = head.getFirstLevelHead()->node;
-        if (!node)
+        if (count == 0)
         {
             cout << "empty" << endl;
             return;
         }
-        while (node)
+        for (iterator it = begin(); it != end(); ++it)
         {
-            cout << *node << (node->next() ? ", " : ".");
-            node = node->next();
+            cout << *it << (it.getNode() != tail ? ", " : ".");
         }
         cout << endl;
     }
     const SkipListNode<T> *getFirstNode()
     {
-        return head.getFirstLevelHead()->node;
+        return head->next();
+    }
+    iterator begin() const
+    {
+        return makeIterator(head->next());
+    }
+    iterator end() const
+    {
+        return makeIterator(nullptr);
+    }
+    reverse_iterator rbegin() const
+    {
+        return reverse_iterator(end());
+    }
+    reverse_iterator rend() const
+    {
+        return reverse_iterator(begin());
+    }
+    // First element not less than value.
+    iterator lower_bound(const T &value) const
+    {
+        SkipListNode<T> *update[MaxLevel];
+        int rank[MaxLevel];
+        return makeIterator(descend(value, update, rank));
+    }
+    // First element greater than value.
+    iterator upper_bound(const T &value) const
+    {
+        SkipListNode<T> *searchNode = head;
+        for (int level = levelCount - 1; level >= 0; level--)
+        {
+            while (searchNode->next(level) && !(value < searchNode->next(level)->value))
+            {
+                searchNode = searchNode->next(level);
+            }
+        }
+        return makeIterator(searchNode->next());
+    }
+    int getLevelCount() const
+    {
+        return levelCount;
+    }
+    // The nodes linked on one level, 0 being the bottom.
+    LevelRange levelItems(int level) const
+    {
+        return LevelRange(SkipListLevelIterator<T>(level < levelCount ? head->next(level) : nullptr, level),
+                          SkipListLevelIterator<T>());
+    }
+    // index-th smallest element, counting from 0; end() if index is out of
+    // range. O(log n) by following the link spans.
+    iterator at(int index) const
+    {
+        if (index < 0 || index >= count)
+        {
+            return end();
+        }
+        const int target = index + 1;
+        SkipListNode<T> *searchNode = head;
+        int position = 0;
+        for (int level = levelCount - 1; level >= 0; level--)
+        {
+            while (searchNode->next(level) && position + searchNode->span(level) <= target)
+            {
+                position += searchNode->span(level);
+                searchNode = searchNode->next(level);
+            }
+            if (position == target)
+            {
+                break;
+            }
+        }
+        return makeIterator(searchNode);
+    }
+    // Number of elements less than value, which is the index value has or
+    // would get.
+    int rankOf(T value) const
+    {
+        SkipListNode<T> *update[MaxLevel];
+        int rank[MaxLevel] = {};
+        descend(value, update, rank);
+        return rank[0];
+    }
+    // Elements with index in [first, last).
+    Range rankRange(int first, int last) const
+    {
+        first = first < 0 ? 0 : first;
+        last = last > count ? count : last;
+        if (first >= last)
+        {
+            return Range(end(), end());
+        }
+        return Range(at(first), at(last));
+    }
+    // The k largest elements, smallest of them first. O(log n + k).
+    Range top(int k) const
+    {
+        return rankRange(count - k, count);
     }
     bool exists(T value)
     {
         const SkipListNode<T> *node = find(value);
         return node;
     }
-    SkipList() : gen(rd()), distr(1, 1000) {}
-    template <typename Container>
-    SkipList(const Container &array) : gen(rd()), distr(1, 1000)
+    void clear()
+    {
+        destroyNodes();
+    }
+    // Replaces the contents with [first, last), linking every level in one
+    // left to right pass. Unsorted input is sorted into a copy first, and
+    // so is single pass input, which the sortedness check would consume.
+    template <typename Iterator>
+    void bulkLoad(Iterator first, Iterator last)
     {
-        for (const auto &value : array)
+        typedef typename iterator_traits<Iterator>::iterator_category Category;
+        if constexpr (!is_base_of<forward_iterator_tag, Category>::value)
         {
-            insert(value);
+            vector<T> staged(first, last);
+            bulkLoad(staged.begin(), staged.end());
+        }
+        else if (!is_sorted(first, last))
+        {
+            vector<T> sorted(first, last);
+            sort(sorted.begin(), sorted.end());
+            bulkLoad(sorted.begin(), sorted.end());
+        }
+        else
+        {
+            clear();
+            vector<SkipListNode<T> *> tails(MaxLevel, head);
+            vector<int> tailRanks(MaxLevel, 0);
+            for (; first != last; ++first)
+            {
+                if (count > 0 && tails[0]->value == *first)
+                {
+                    continue;
+                }
+                appendNode(SkipListNode<T>::create(pool, *first, getRandomLevelCount()), tails, tailRanks);
+            }
+            finishAppend(tails, tailRanks);
         }
     }
-    ~SkipList()
+    // Moves the elements of other into this list, other is left empty and
+    // values present in both are kept once. When all of other sorts after
+    // this list the levels are joined in O(log n); otherwise both bottom
+    // levels are merged and every level relinked in O(n + m). Both lists
+    // keep using each other's memory.
+    void merge(SkipList &other)
     {
-        SkipListNode<T> *node = head.getFirstLevelHead()->node;
-        while (node)
+        if (&other == this || other.count == 0)
         {
-            SkipListNode<T> *temp = node->next();
-            delete node;
-            node = temp;
+            return;
+        }
+        pool.share(other.pool);
+        if (count > 0 && !(tail->value < other.head->next()->value))
+        {
+            SkipListNode<T> *mine = head->next();
+            SkipListNode<T> *theirs = other.head->next();
+            other.detachNodes();
+            detachNodes();
+            vector<SkipListNode<T> *> tails(MaxLevel, head);
+            vector<int> tailRanks(MaxLevel, 0);
+            while (mine || theirs)
+            {
+                SkipListNode<T> *node;
+                if (!theirs || (mine && mine->value < theirs->value))
+                {
+                    node = mine;
+                    mine = mine->next();
+                }
+                else if (!mine || theirs->value < mine->value)
+                {
+                    node = theirs;
+                    theirs = theirs->next();
+                }
+                else
+                {
+                    node = theirs;
+                    theirs = theirs->next();
+                    SkipListNode<T>::destroy(pool, node);
+                    continue;
+                }
+                appendNode(node, tails, tailRanks);
+            }
+            finishAppend(tails, tailRanks);
+            return;
+        }
+
+        // Last node of every level, other's levels are hung behind them.
+        SkipListNode<T> *update[MaxLevel];
+        int rank[MaxLevel];
+        SkipListNode<T> *searchNode = head;
+        int position = 0;
+        for (int level = levelCount - 1; level >= 0; level--)
+        {
+            while (searchNode->next(level))
+            {
+                position += searchNode->span(level);
+                searchNode = searchNode->next(level);
+            }
+            update[level] = searchNode;
+            rank[level] = position;
+        }
+        for (; levelCount < other.levelCount; levelCount++)
+        {
+            update[levelCount] = head;
+            rank[levelCount] = 0;
+        }
+        for (int level = 0; level < levelCount; level++)
+        {
+            if (level < other.levelCount)
+            {
+                update[level]->setNext(other.head->next(level), level);
+                update[level]->setSpan(count - rank[level] + other.head->span(level), level);
+            }
+            else
+            {
+                update[level]->setSpan(update[level]->span(level) + other.count, level);
+            }
         }
+        other.head->next()->setPrev(tail);
+        tail = other.tail;
+        count += other.count;
+        other.detachNodes();
+    }
+    // Moves the elements not less than key into greater, replacing what it
+    // held. O(log n); both lists keep using the memory of this one.
+    void split(const T &key, SkipList &greater)
+    {
+        if (&greater == this)
+        {
+            return;
+        }
+        greater.clear();
+        greater.pool.share(pool);
+        SkipListNode<T> *update[MaxLevel];
+        int rank[MaxLevel];
+        SkipListNode<T> *first = descend(key, update, rank);
+        if (!first)
+        {
+            return;
+        }
+        const int kept = rank[0];
+        for (int level = 0; level < levelCount; level++)
+        {
+            greater.head->setNext(update[level]->next(level), level);
+            greater.head->setSpan(rank[level] + update[level]->span(level) - kept, level);
+            update[level]->setNext(nullptr, level);
+            update[level]->setSpan(kept + 1 - rank[level], level);
+        }
+        first->setPrev(nullptr);
+        greater.levelCount = levelCount;
+        greater.count = count - kept;
+        greater.tail = tail;
+        greater.trimLevels();
+        tail = update[0] == head ? nullptr : update[0];
+        count = kept;
+        trimLevels();
+    }
+    // Writes the values in order as a SortedKeys snapshot.
+    bool save(const string &path) const
+    {
+        SnapshotWriter<T> writer(path, SortedKeys);
+        for (const SkipListNode<T> *node = head->next(); node; node = node->next())
+        {
+            writer.write(node->value);
+        }
+        return writer.close();
+    }
+    bool load(const string &path)
+    {
+        MappedSnapshot<T> snapshot(path, SortedKeys);
+        if (!snapshot.valid())
+        {
+            return false;
+        }
+        bulkLoad(snapshot.begin(), snapshot.end());
+        return true;
+    }
+    SkipList(const SkipList &) = delete;
+    SkipList &operator=(const SkipList &) = delete;
+    explicit SkipList(const LevelGenerator &levels = LevelGenerator())
+        : head(SkipListNode<T>::create(pool, T(), MaxLevel)), levels(levels)
+    {
+    }
+    template <typename Container>
+    SkipList(const Container &array, const LevelGenerator &levels = LevelGenerator())
+        : head(SkipListNode<T>::create(pool, T(), MaxLevel)), levels(levels)
+    {
+        bulkLoad(std::begin(array), std::end(array));
+    }
+    ~SkipList()
+    {
+        destroyNodes();
+        SkipListNode<T>::destroy(pool, head);
     }
 };
 void taskA()
@@ -453,8 +874,9 @@ void taskA()
             int number;
             cout << "Enter a number to insert: ";
             cin >> number;
-            SkipListNode<int> *r = skipList.insert(number);
-            if (r)
+            pair<SkipList<int>::iterator, bool> inserted = skipList.insert(number);
+            const SkipListNode<int> *r = inserted.first.getNode();
+            if (inserted.second)
             {
                 cout << *r << " is inserted up to level " << r->getLevelCount();
                 if (r->next())
@@ -561,41 +983,39 @@ class ScoreManager
 {
 private:
     SkipList<Score> scoresByScore;
-    SkipList<Score> scoresByName;
+    HashTableString scoresByName;
 
 public:
+    ScoreManager() : scoresByName(16) {}
     bool addScore(string name, unsigned int score)
     {
         Score byScore(score, name, true);
-        Score byName(score, name, false);
-        if (scoresByName.exists(byName))
+        if (scoresByName.searchElement(name) != -1)
         {
             cout << "Player " << name << " already exists!" << endl;
             return false;
         }
         scoresByScore.insert(byScore);
-        scoresByName.insert(byName);
+        scoresByName.insertElement(name, score);
         return true;
     }
     int getScore(string name)
     {
-        Score byName(0, name, false);
-        const SkipListNode<Score> *node = scoresByName.find(byName);
-        if (!node)
+        int index = scoresByName.searchElement(name);
+        if (index == -1)
         {
             return -1;
         }
-        return node->value.score;
+        return scoresByName.getValue(index);
     }
     bool removeScore(string name)
     {
-        Score byName(0, name, false);
-        const SkipListNode<Score> *record = scoresByName.find(byName);
-        if (record)
+        int index = scoresByName.searchElement(name);
+        if (index != -1)
         {
-            int score = record->value.score;
+            int score = scoresByName.getValue(index);
             Score byScore(score, name, true);
-            scoresByName.remove(byName);
+            scoresByName.deleteElement(name);
             scoresByScore.remove(byScore);
             return true;
         }
@@ -629,18 +1049,10 @@ public:
         else
         {
             cout << "Top " << count << ":" << endl;
-            const SkipListNode<Score> *node = scoresByScore.getFirstNode();
-            const int printIndex = scoresByScore.getCount() - count;
-            int index = 0;
-            while (node)
+            SkipList<Score>::reverse_iterator it = scoresByScore.rbegin();
+            for (unsigned int printed = 0; printed < count; printed++, ++it)
             {
-                if (index >= printIndex)
-                {
-                    cout << *node << ",, ";
-                }
-
-                node = node->next();
-                index++;
+                cout << *it << ",, ";
             }
             cout << endl;
         }
@@ -754,6 +1166,7 @@ void taskB()
         }
     }
 }
+#ifndef NO_MAIN
 int main()
 {
     cout << "Task 3: " << endl;
@@ -776,4 +1189,7 @@ int main()
         main();
         break;
     }
-}
\ No newline at end of file
+}
+#endif
+
+#endif
@@ -0,0 +1,133 @@
+#ifndef SKIPLISTLEVELS_CPP
+#define SKIPLISTLEVELS_CPP
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <random>
+using namespace std;
+
+// Tallest tower any skip list builds; the head sentinel is this tall.
+const int SkipListMaxLevel = 32;
+
+// xorshift64*: one multiply and three shifts per 64 random bits. The
+// multiply only mixes upwards, so the high bits of a draw are the strong
+// ones; the low bits are as weak as the plain xorshift state.
+class XorShift64
+{
+    uint64_t state;
+
+public:
+    explicit XorShift64(uint64_t seed) : state(seed != 0 ? seed : 0x9E3779B97F4A7C15ull) {}
+
+    uint64_t next()
+    {
+        state ^= state >> 12;
+        state ^= state << 25;
+        state ^= state >> 27;
+        return state * 0x2545F4914F6CDD1Dull;
+    }
+};
+
+inline uint64_t randomLevelSeed()
+{
+    random_device rd;
+    return (uint64_t)rd() << 32 | rd();
+}
+
+// splitmix64 of seed and stream, for several generators from one seed.
+inline uint64_t mixSeed(uint64_t seed, uint64_t stream)
+{
+    uint64_t z = seed + (stream + 1) * 0x9E3779B97F4A7C15ull;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+// Levels needed so that about one node reaches the top of a list of
+// expectedSize elements, with 0 meaning no limit below SkipListMaxLevel.
+inline int levelsFor(size_t expectedSize, double p)
+{
+    if (expectedSize == 0)
+        return SkipListMaxLevel;
+    int levels = (int)ceil(log((double)expectedSize) / log(1.0 / p));
+    return levels < 1 ? 1 : levels > SkipListMaxLevel ? SkipListMaxLevel : levels;
+}
+
+// Level generators hand out tower heights h >= 1 with P(h > k) = p^k, capped
+// at maxLevel(). They are seeded explicitly for reproducible runs, or from
+// random_device by default.
+
+// p = 1 / 2^BitsPerLevel, taken from the leading zero bits of one draw.
+template <int BitsPerLevel>
+class PowerOfTwoLevels
+{
+    static_assert(BitsPerLevel >= 1 && BitsPerLevel * SkipListMaxLevel <= 64, "one draw must cover every level");
+
+    XorShift64 random;
+    int cap;
+
+public:
+    static constexpr double p = 1.0 / (1 << BitsPerLevel);
+
+    explicit PowerOfTwoLevels(uint64_t seed = randomLevelSeed(), size_t expectedSize = 0)
+        : random(seed), cap(levelsFor(expectedSize, p))
+    {
+    }
+
+    int maxLevel() const
+    {
+        return cap;
+    }
+
+    int next()
+    {
+        uint64_t bits = random.next();
+        int level = 1 + (bits != 0 ? __builtin_clzll(bits) : 64) / BitsPerLevel;
+        return level < cap ? level : cap;
+    }
+};
+
+typedef PowerOfTwoLevels<1> HalfLevels;
+typedef PowerOfTwoLevels<2> QuarterLevels;
+
+// p = 1/e, the p with the fewest expected comparisons per search. Every 16
+// bits of a draw, from the top down, decide one level against 65536/e.
+class InverseELevels
+{
+    static const uint64_t Threshold = 24109;
+
+    XorShift64 random;
+    int cap;
+
+public:
+    static constexpr double p = 0.36787944117144233;
+
+    explicit InverseELevels(uint64_t seed = randomLevelSeed(), size_t expectedSize = 0)
+        : random(seed), cap(levelsFor(expectedSize, p))
+    {
+    }
+
+    int maxLevel() const
+    {
+        return cap;
+    }
+
+    int next()
+    {
+        int level = 1;
+        while (level < cap)
+        {
+            uint64_t bits = random.next();
+            for (int slice = 0; slice < 4 && level < cap; slice++, bits <<= 16)
+            {
+                if ((bits >> 48) >= Threshold)
+                    return level;
+                level++;
+            }
+        }
+        return level;
+    }
+};
+
+#endif
@@ -0,0 +1,442 @@
+#define NO_MAIN
+#include <iostream>
+#include <cassert>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <iterator>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "SkipList.cpp"
+
+// Contents and count match reference, and every level is a sorted subset
+// of the bottom one.
+template <class T, class Levels>
+void checkList(SkipList<T, Levels> &list, const set<T> &reference) {
+    assert(list.getCount() == (int)reference.size());
+    assert(equal(list.begin(), list.end(), reference.begin(), reference.end()));
+    assert(list.getLevelCount() >= 1 && list.getLevelCount() <= SkipListMaxLevel);
+    for (int level = 1; level < list.getLevelCount(); level++) {
+        const T *previous = nullptr;
+        for (const T &value : list.levelItems(level)) {
+            assert(previous == nullptr || *previous < value);
+            assert(reference.count(value) == 1);
+            previous = &value;
+        }
+    }
+}
+
+// at(i) and rankOf agree with the sorted reference for every element and
+// for the gaps between them, which only holds if every span is right.
+void checkRanks(SkipList<int> &list, const set<int> &reference) {
+    vector<int> sorted(reference.begin(), reference.end());
+    const int n = (int)sorted.size();
+    assert(list.at(-1) == list.end() && list.at(n) == list.end());
+    for (int i = 0; i < n; i++) {
+        assert(*list.at(i) == sorted[i]);
+        assert(list.rankOf(sorted[i]) == i);
+        assert(list.rankOf(sorted[i] + 1) == i + 1);
+    }
+    for (int k : {0, 1, n / 2, n, n + 5}) {
+        auto top = list.top(k);
+        int shown = k < n ? k : n;
+        assert(equal(top.begin(), top.end(), sorted.end() - shown, sorted.end()));
+    }
+    auto middle = list.rankRange(n / 4, n / 2);
+    assert(equal(middle.begin(), middle.end(), sorted.begin() + n / 4, sorted.begin() + n / 2));
+}
+
+void testRandomInsertRemove() {
+    SkipList<int> list{HalfLevels(1)};
+    set<int> reference;
+    mt19937 gen(1);
+    for (int i = 0; i < 50000; i++) {
+        int value = gen() % 3000;
+        int op = gen() % 3;
+        if (op == 0) {
+            auto inserted = list.insert(value);
+            assert(inserted.second == reference.insert(value).second);
+            assert(*inserted.first == value);
+        }
+        else if (op == 1) {
+            assert(list.remove(value) == (reference.erase(value) == 1));
+        }
+        else {
+            assert(list.exists(value) == (reference.count(value) == 1));
+            const SkipListNode<int> *node = list.find(value);
+            assert((node != nullptr) == (reference.count(value) == 1));
+            assert(node == nullptr || node->value == value);
+        }
+        if (i % 5000 == 0) {
+            checkList(list, reference);
+        }
+    }
+    checkList(list, reference);
+}
+
+// The head sentinel has no value of its own: inserting below the smallest
+// element, removing down to empty and refilling all go through it.
+void testEmptyAndEdges() {
+    SkipList<int> list{HalfLevels(2)};
+    set<int> reference;
+    assert(list.getCount() == 0 && list.begin() == list.end());
+    assert(!list.remove(0) && !list.exists(0) && list.find(0) == nullptr);
+
+    for (int i = 1000; i > 0; i--) {
+        list.insert(i);
+        reference.insert(i);
+    }
+    assert(*list.begin() == 1);
+    list.insert(0);
+    reference.insert(0);
+    assert(!list.insert(0).second);
+    checkList(list, reference);
+
+    for (int i = 0; i <= 1000; i++) {
+        assert(list.remove(i));
+    }
+    reference.clear();
+    checkList(list, reference);
+    assert(list.getLevelCount() == 1);
+
+    list.insert(5);
+    reference.insert(5);
+    checkList(list, reference);
+    list.clear();
+    reference.clear();
+    checkList(list, reference);
+    checkRanks(list, reference);
+}
+
+// Spans stay right through inserts and removes at every level, and a
+// list loaded from a snapshot rebuilds them before changing again.
+void testRanks() {
+    const string path = "SkipListTest.snap";
+    SkipList<int> list{HalfLevels(4)};
+    set<int> reference;
+    mt19937 gen(4);
+    for (int round = 0; round < 20; round++) {
+        for (int i = 0; i < 500; i++) {
+            int value = gen() % 2000;
+            if (gen() % 3 != 0) {
+                list.insert(value);
+                reference.insert(value);
+            }
+            else {
+                list.remove(value);
+                reference.erase(value);
+            }
+        }
+        checkRanks(list, reference);
+    }
+
+    assert(list.save(path));
+    SkipList<int> loaded{HalfLevels(5)};
+    loaded.insert(-1);
+    assert(loaded.load(path));
+    checkList(loaded, reference);
+    checkRanks(loaded, reference);
+    for (int i = 0; i < 2000; i++) {
+        int value = gen() % 2000;
+        if (gen() % 2 == 0) {
+            loaded.insert(value);
+            reference.insert(value);
+        }
+        else {
+            loaded.remove(value);
+            reference.erase(value);
+        }
+    }
+    checkRanks(loaded, reference);
+    remove(path.c_str());
+}
+
+// Walking back from end() sees the forward walk reversed, so every prev
+// link and the tail survive removes, including of the first and last.
+void checkReverse(SkipList<int> &list) {
+    vector<int> forward(list.begin(), list.end());
+    vector<int> backward(list.rbegin(), list.rend());
+    assert(equal(forward.rbegin(), forward.rend(), backward.begin(), backward.end()));
+    vector<int> stepped;
+    for (auto it = list.end(); it != list.begin();) {
+        --it;
+        stepped.push_back(*it);
+    }
+    assert(stepped == backward);
+}
+
+// lower_bound and upper_bound agree with std::set for present values,
+// gaps between them and values past either end.
+void checkBounds(SkipList<int> &list, const set<int> &reference, int low, int high) {
+    for (int value = low; value <= high; value++) {
+        auto lower = list.lower_bound(value);
+        auto expectedLower = reference.lower_bound(value);
+        assert((lower == list.end()) == (expectedLower == reference.end()));
+        assert(lower == list.end() || *lower == *expectedLower);
+        auto upper = list.upper_bound(value);
+        auto expectedUpper = reference.upper_bound(value);
+        assert((upper == list.end()) == (expectedUpper == reference.end()));
+        assert(upper == list.end() || *upper == *expectedUpper);
+    }
+}
+
+void testReverseAndBounds() {
+    SkipList<int> list{HalfLevels(6)};
+    set<int> reference;
+    assert(list.rbegin() == list.rend());
+    checkBounds(list, reference, -2, 2);
+
+    mt19937 gen(6);
+    for (int i = 0; i < 3000; i++) {
+        int value = 3 * (gen() % 1000);
+        list.insert(value);
+        reference.insert(value);
+    }
+    checkReverse(list);
+    checkBounds(list, reference, -5, 3005);
+
+    for (int round = 0; round < 10; round++) {
+        list.remove(*list.begin());
+        reference.erase(reference.begin());
+        list.remove(*list.rbegin());
+        reference.erase(prev(reference.end()));
+        for (int i = 0; i < 100; i++) {
+            int value = 3 * (gen() % 1000);
+            list.remove(value);
+            reference.erase(value);
+        }
+        checkReverse(list);
+        checkBounds(list, reference, -5, 3005);
+    }
+
+    while (list.getCount() > 0) {
+        list.remove(*list.rbegin());
+    }
+    reference.clear();
+    assert(list.rbegin() == list.rend());
+    list.insert(7);
+    reference.insert(7);
+    checkReverse(list);
+    checkBounds(list, reference, 5, 9);
+}
+
+// Everything a list can be checked against its reference for, then once
+// more after a few changes so the rebuilt links keep working.
+void checkAll(SkipList<int> &list, set<int> &reference, mt19937 &gen) {
+    checkList(list, reference);
+    checkRanks(list, reference);
+    checkReverse(list);
+    for (int i = 0; i < 200; i++) {
+        int value = gen() % 6000;
+        if (gen() % 2 == 0) {
+            assert(list.insert(value).second == reference.insert(value).second);
+        }
+        else {
+            assert(list.remove(value) == (reference.erase(value) == 1));
+        }
+    }
+    checkList(list, reference);
+    checkRanks(list, reference);
+    checkReverse(list);
+}
+
+void testBulkLoad() {
+    mt19937 gen(7);
+    vector<int> values;
+    for (int i = 0; i < 5000; i++) {
+        values.push_back(gen() % 3000);
+    }
+    set<int> reference(values.begin(), values.end());
+
+    // Unsorted with duplicates, replacing what the list held.
+    SkipList<int> list{HalfLevels(7)};
+    list.insert(-5);
+    list.bulkLoad(values.begin(), values.end());
+    set<int> copy = reference;
+    checkAll(list, copy, gen);
+
+    // Sorted with duplicates.
+    vector<int> sorted = values;
+    sort(sorted.begin(), sorted.end());
+    list.bulkLoad(sorted.begin(), sorted.end());
+    copy = reference;
+    checkAll(list, copy, gen);
+
+    // Single pass input is read once, sorted or not; distinct values so a
+    // value skipped by a second pass would go missing.
+    stringstream ascending;
+    stringstream descending;
+    for (int value : reference) {
+        ascending << value << ' ';
+    }
+    for (auto it = reference.rbegin(); it != reference.rend(); ++it) {
+        descending << *it << ' ';
+    }
+    list.bulkLoad(istream_iterator<int>(ascending), istream_iterator<int>());
+    copy = reference;
+    checkAll(list, copy, gen);
+    list.bulkLoad(istream_iterator<int>(descending), istream_iterator<int>());
+    copy = reference;
+    checkAll(list, copy, gen);
+
+    list.bulkLoad(values.begin(), values.begin());
+    copy.clear();
+    checkAll(list, copy, gen);
+
+    SkipList<int> built(sorted, HalfLevels(8));
+    copy = reference;
+    checkAll(built, copy, gen);
+}
+
+// Fills list and reference with count values from [low, high).
+void fill(SkipList<int> &list, set<int> &reference, int count, int low, int high, mt19937 &gen) {
+    for (int i = 0; i < count; i++) {
+        int value = low + gen() % (high - low);
+        list.insert(value);
+        reference.insert(value);
+    }
+}
+
+void testMerge() {
+    mt19937 gen(9);
+
+    // Other sorts after this list: its levels are hung behind ours. The
+    // larger list on the right tends to bring taller towers along.
+    SkipList<int> left{HalfLevels(9)};
+    SkipList<int> right{HalfLevels(10)};
+    set<int> reference;
+    set<int> rightReference;
+    fill(left, reference, 100, 0, 1000, gen);
+    fill(right, rightReference, 3000, 1000, 5000, gen);
+    reference.insert(rightReference.begin(), rightReference.end());
+    left.merge(right);
+    assert(right.getCount() == 0 && right.begin() == right.end() && right.rbegin() == right.rend());
+    checkAll(left, reference, gen);
+    set<int> none;
+    checkAll(right, none, gen);
+
+    // Interleaved ranges with shared values take the relinking path.
+    SkipList<int> a{HalfLevels(11)};
+    SkipList<int> b{HalfLevels(12)};
+    set<int> aReference;
+    set<int> bReference;
+    fill(a, aReference, 2000, 0, 4000, gen);
+    fill(b, bReference, 2000, 2000, 6000, gen);
+    aReference.insert(bReference.begin(), bReference.end());
+    a.merge(b);
+    assert(b.getCount() == 0 && b.begin() == b.end());
+    checkAll(a, aReference, gen);
+
+    // Other starting at our last value is not strictly after us.
+    SkipList<int> c{HalfLevels(13)};
+    SkipList<int> d{HalfLevels(14)};
+    for (int i = 0; i <= 10; i++) {
+        c.insert(i);
+        d.insert(10 + i);
+    }
+    c.merge(d);
+    set<int> cReference;
+    for (int i = 0; i <= 20; i++) {
+        cReference.insert(i);
+    }
+    checkAll(c, cReference, gen);
+
+    // Into an empty list, and with itself.
+    SkipList<int> empty{HalfLevels(15)};
+    empty.merge(c);
+    checkAll(empty, cReference, gen);
+    empty.merge(empty);
+    checkAll(empty, cReference, gen);
+}
+
+void testSplit() {
+    mt19937 gen(16);
+    for (int key : {-1, 0, 1500, 1501, 2999, 3000, 4000}) {
+        SkipList<int> list{HalfLevels(16)};
+        SkipList<int> greater{HalfLevels(17)};
+        set<int> reference;
+        fill(list, reference, 2000, 0, 3000, gen);
+        list.insert(1500);
+        reference.insert(1500);
+        greater.insert(-7);
+
+        list.split(key, greater);
+        set<int> below(reference.begin(), reference.lower_bound(key));
+        set<int> above(reference.lower_bound(key), reference.end());
+        assert(list.getCount() == (int)below.size() && greater.getCount() == (int)above.size());
+        checkAll(list, below, gen);
+        checkAll(greater, above, gen);
+
+        // The halves join back into one list.
+        below.insert(above.begin(), above.end());
+        list.merge(greater);
+        checkAll(list, below, gen);
+    }
+}
+
+// Values with their own storage exercise the tower placed after the value.
+void testStrings() {
+    SkipList<string> list{HalfLevels(3)};
+    set<string> reference;
+    mt19937 gen(3);
+    for (int i = 0; i < 5000; i++) {
+        string value = "key-" + to_string(gen() % 700) + string(gen() % 40, 'x');
+        if (gen() % 3 != 0) {
+            assert(list.insert(value).second == reference.insert(value).second);
+        }
+        else {
+            assert(list.remove(value) == (reference.erase(value) == 1));
+        }
+    }
+    checkList(list, reference);
+}
+
+// Fraction of draws with a tower taller than k is close to p^k, the same
+// seed repeats the same towers, and the cap is respected.
+template <class Levels>
+void checkLevels(double p) {
+    const int draws = 1 << 20;
+    Levels levels(7);
+    Levels again(7);
+    vector<int> taller(8, 0);
+    for (int i = 0; i < draws; i++) {
+        int level = levels.next();
+        assert(level == again.next());
+        assert(level >= 1 && level <= levels.maxLevel());
+        for (int k = 0; k < 8 && level > k; k++) {
+            taller[k]++;
+        }
+    }
+    for (int k = 1; k < 5; k++) {
+        double expected = pow(p, k);
+        assert(fabs((double)taller[k] / draws - expected) < 0.05 * expected);
+    }
+
+    Levels capped(7, 1000);
+    assert(capped.maxLevel() == (int)ceil(log(1000.0) / log(1.0 / p)));
+    for (int i = 0; i < 10000; i++) {
+        assert(capped.next() <= capped.maxLevel());
+    }
+}
+
+void testLevelGenerators() {
+    checkLevels<HalfLevels>(HalfLevels::p);
+    checkLevels<QuarterLevels>(QuarterLevels::p);
+    checkLevels<InverseELevels>(InverseELevels::p);
+}
+
+int main() {
+    testRandomInsertRemove();
+    testEmptyAndEdges();
+    testRanks();
+    testReverseAndBounds();
+    testBulkLoad();
+    testMerge();
+    testSplit();
+    testStrings();
+    testLevelGenerators();
+    std::cout << "All tests passed!" << std::endl;
+    return 0;
+}
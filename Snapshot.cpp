@@ -0,0 +1,176 @@
+#ifndef SNAPSHOT_CPP
+#define SNAPSHOT_CPP
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <type_traits>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+using namespace std;
+
+// Binary snapshot: a 64 byte header followed by count fixed-size records
+// written as they are in memory, so the records can be mapped and used
+// in place. Records must be trivially copyable, and a snapshot is only
+// read back on a machine with the same layout.
+enum SnapshotLayout : uint32_t
+{
+    SortedKeys = 1,
+    CompactNodes = 2
+};
+
+struct SnapshotHeader
+{
+    char magic[8];
+    uint32_t layout;
+    uint32_t recordSize;
+    uint64_t count;
+    // Filled in by the container for CompactNodes, zero otherwise.
+    uint64_t root;
+    uint64_t freeList;
+    uint64_t keyCount;
+    uint64_t reserved[2];
+};
+
+static const char SnapshotMagic[8] = {'D', 'S', 'S', 'N', 'A', 'P', '0', '1'};
+
+// Streams records to a file through a fixed buffer; the header is
+// written up front and its count patched in by close().
+template <class Record>
+class SnapshotWriter
+{
+    static_assert(is_trivially_copyable<Record>::value, "snapshot records are written as raw bytes");
+    static const size_t BufferRecords = 1 << 14;
+
+    ofstream out;
+    vector<Record> buffer;
+    SnapshotHeader fileHeader;
+
+    void flush()
+    {
+        out.write(reinterpret_cast<const char *>(buffer.data()), buffer.size() * sizeof(Record));
+        buffer.clear();
+    }
+
+public:
+    SnapshotWriter(const string &path, SnapshotLayout layout) : out(path, ios::binary | ios::trunc)
+    {
+        memset(&fileHeader, 0, sizeof(fileHeader));
+        memcpy(fileHeader.magic, SnapshotMagic, sizeof(SnapshotMagic));
+        fileHeader.layout = layout;
+        fileHeader.recordSize = sizeof(Record);
+        out.write(reinterpret_cast<const char *>(&fileHeader), sizeof(fileHeader));
+        buffer.reserve(BufferRecords);
+    }
+
+    SnapshotHeader &header()
+    {
+        return fileHeader;
+    }
+
+    void write(const Record &record)
+    {
+        buffer.push_back(record);
+        fileHeader.count++;
+        if (buffer.size() == BufferRecords)
+            flush();
+    }
+
+    // false if any write failed.
+    bool close()
+    {
+        flush();
+        out.seekp(0);
+        out.write(reinterpret_cast<const char *>(&fileHeader), sizeof(fileHeader));
+        out.close();
+        return !out.fail();
+    }
+};
+
+// Read-only view of a snapshot file mapped into memory. The records are
+// used in place: nothing is read until it is touched.
+template <class Record>
+class MappedSnapshot
+{
+    static_assert(is_trivially_copyable<Record>::value, "snapshot records are read as raw bytes");
+
+    void *mapping = MAP_FAILED;
+    size_t mappedBytes = 0;
+    const SnapshotHeader *fileHeader = nullptr;
+    const Record *records = nullptr;
+
+public:
+    MappedSnapshot(const string &path, SnapshotLayout layout)
+    {
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+            return;
+        struct stat info;
+        if (fstat(fd, &info) == 0 && (size_t)info.st_size >= sizeof(SnapshotHeader))
+        {
+            mappedBytes = info.st_size;
+            mapping = mmap(nullptr, mappedBytes, PROT_READ, MAP_PRIVATE, fd, 0);
+        }
+        close(fd);
+        if (mapping == MAP_FAILED)
+            return;
+
+        const SnapshotHeader *candidate = static_cast<const SnapshotHeader *>(mapping);
+        if (memcmp(candidate->magic, SnapshotMagic, sizeof(SnapshotMagic)) != 0 || candidate->layout != layout ||
+            candidate->recordSize != sizeof(Record) ||
+            candidate->count != (mappedBytes - sizeof(SnapshotHeader)) / sizeof(Record) ||
+            (mappedBytes - sizeof(SnapshotHeader)) % sizeof(Record) != 0)
+            return;
+        fileHeader = candidate;
+        records = reinterpret_cast<const Record *>(static_cast<const char *>(mapping) + sizeof(SnapshotHeader));
+        madvise(mapping, mappedBytes, MADV_SEQUENTIAL);
+    }
+
+    MappedSnapshot(const MappedSnapshot &) = delete;
+    MappedSnapshot &operator=(const MappedSnapshot &) = delete;
+
+    ~MappedSnapshot()
+    {
+        if (mapping != MAP_FAILED)
+            munmap(mapping, mappedBytes);
+    }
+
+    // false when the file is missing, truncated or of another layout.
+    bool valid() const
+    {
+        return fileHeader != nullptr;
+    }
+
+    const SnapshotHeader &header() const
+    {
+        return *fileHeader;
+    }
+
+    size_t size() const
+    {
+        return valid() ? fileHeader->count : 0;
+    }
+
+    const Record *begin() const
+    {
+        return records;
+    }
+
+    const Record *end() const
+    {
+        return records + size();
+    }
+
+    // Binary search over a SortedKeys snapshot, without loading it.
+    bool contains(const Record &key) const
+    {
+        const Record *it = lower_bound(begin(), end(), key);
+        return it != end() && !(key < *it);
+    }
+};
+
+#endif
@@ -0,0 +1,173 @@
+#define NO_MAIN
+#include <iostream>
+#include <cassert>
+#include <cstdio>
+#include <fstream>
+#include <random>
+#include <string>
+#include <vector>
+#include "RedBlackTree.cpp"
+#include "SkipList.cpp"
+#include "CompactRedBlackTree.cpp"
+
+static const string snapshotPath = "SnapshotTest.snap";
+
+// Overwrites size bytes of the file at offset.
+void patchFile(const string &path, size_t offset, const void *bytes, size_t size) {
+    fstream file(path, ios::binary | ios::in | ios::out);
+    file.seekp(offset);
+    file.write(static_cast<const char *>(bytes), size);
+}
+
+void truncateFile(const string &path, size_t size) {
+    ifstream in(path, ios::binary);
+    vector<char> bytes(size);
+    in.read(bytes.data(), size);
+    in.close();
+    ofstream out(path, ios::binary | ios::trunc);
+    out.write(bytes.data(), size);
+}
+
+void testSortedKeysRoundTrip() {
+    vector<int> values;
+    mt19937 gen(1);
+    for (int i = 0; i < 50000; i++) {
+        values.push_back(gen() % 1000000);
+    }
+
+    RedBlackTree<int> tree;
+    for (int value : values) {
+        tree.Insert(value);
+    }
+    assert(tree.save(snapshotPath));
+    RedBlackTree<int> treeCopy;
+    assert(treeCopy.load(snapshotPath));
+    assert(treeCopy.validate());
+    assert(equal(tree.begin(), tree.end(), treeCopy.begin(), treeCopy.end()));
+
+    SkipList<int> list;
+    list.bulkLoad(values.begin(), values.end());
+    assert(list.save(snapshotPath));
+    SkipList<int> listCopy;
+    assert(listCopy.load(snapshotPath));
+    assert(listCopy.getCount() == list.getCount());
+    assert(equal(list.begin(), list.end(), listCopy.begin(), listCopy.end()));
+    for (int i = 0; i < listCopy.getCount(); i += 97) {
+        assert(listCopy.rankOf(*listCopy.at(i)) == i);
+    }
+
+    MappedSnapshot<int> mapped(snapshotPath, SortedKeys);
+    assert(mapped.valid() && mapped.size() == (size_t)list.getCount());
+    for (int i = 0; i < 1000; i++) {
+        int value = gen() % 1000000;
+        assert(mapped.contains(value) == list.exists(value));
+    }
+
+    RedBlackTree<int> empty;
+    assert(empty.save(snapshotPath));
+    assert(treeCopy.load(snapshotPath));
+    assert(treeCopy.empty());
+}
+
+void testCompactRoundTrip() {
+    CompactRedBlackTree<int> tree;
+    for (int i = 0; i < 5000; i++) {
+        tree.Insert(i * 7 % 5000);
+    }
+    for (int i = 0; i < 5000; i += 3) {
+        tree.Delete(i);
+    }
+    assert(tree.save(snapshotPath));
+    CompactRedBlackTree<int> copy;
+    assert(copy.load(snapshotPath));
+    assert(copy.validate());
+    assert(copy.size() == tree.size());
+    for (int i = 0; i < 5000; i++) {
+        assert(copy.contains(i) == (i % 3 != 0));
+    }
+    // The free list came along, new keys take the freed slots.
+    size_t bytes = copy.memoryUsage();
+    copy.Insert(3);
+    assert(copy.validate() && copy.memoryUsage() == bytes);
+}
+
+// Every damaged file is rejected and leaves the container as it was.
+void testCorruptHeaders() {
+    RedBlackTree<int> source(vector<int>{1, 2, 3, 4, 5});
+    RedBlackTree<int> tree(vector<int>{42});
+
+    assert(source.save(snapshotPath));
+    char badMagic = 'X';
+    patchFile(snapshotPath, 0, &badMagic, 1);
+    assert(!tree.load(snapshotPath));
+
+    assert(source.save(snapshotPath));
+    uint32_t wrongLayout = CompactNodes;
+    patchFile(snapshotPath, offsetof(SnapshotHeader, layout), &wrongLayout, sizeof(wrongLayout));
+    assert(!tree.load(snapshotPath));
+
+    assert(source.save(snapshotPath));
+    uint32_t wrongRecordSize = 8;
+    patchFile(snapshotPath, offsetof(SnapshotHeader, recordSize), &wrongRecordSize, sizeof(wrongRecordSize));
+    assert(!tree.load(snapshotPath));
+
+    assert(source.save(snapshotPath));
+    uint64_t wrongCount = 6;
+    patchFile(snapshotPath, offsetof(SnapshotHeader, count), &wrongCount, sizeof(wrongCount));
+    assert(!tree.load(snapshotPath));
+
+    assert(source.save(snapshotPath));
+    truncateFile(snapshotPath, sizeof(SnapshotHeader) + 2 * sizeof(int) + 1);
+    assert(!tree.load(snapshotPath));
+    truncateFile(snapshotPath, sizeof(SnapshotHeader) - 1);
+    assert(!tree.load(snapshotPath));
+
+    assert(!tree.load("SnapshotTest.missing"));
+    assert(tree.size() == 1 && tree.contains(42));
+}
+
+// Compact snapshots carry raw indices; any one out of range is rejected.
+void testCorruptCompactNodes() {
+    CompactRedBlackTree<int> source;
+    for (int i = 0; i < 100; i++) {
+        source.Insert(i);
+    }
+    CompactRedBlackTree<int> tree;
+    tree.Insert(42);
+    const size_t firstNode = sizeof(SnapshotHeader) + sizeof(CompactNode<int>);
+    const uint32_t outOfRange = 1000;
+
+    size_t fields[] = {offsetof(CompactNode<int>, left), offsetof(CompactNode<int>, right),
+                       offsetof(CompactNode<int>, parentAndColor)};
+    for (size_t field : fields) {
+        assert(source.save(snapshotPath));
+        uint32_t value = field == offsetof(CompactNode<int>, parentAndColor) ? outOfRange << 1 : outOfRange;
+        patchFile(snapshotPath, firstNode + 50 * sizeof(CompactNode<int>) + field, &value, sizeof(value));
+        assert(!tree.load(snapshotPath));
+    }
+
+    uint64_t headerFields[] = {offsetof(SnapshotHeader, root), offsetof(SnapshotHeader, freeList),
+                               offsetof(SnapshotHeader, keyCount)};
+    for (uint64_t field : headerFields) {
+        assert(source.save(snapshotPath));
+        uint64_t value = outOfRange;
+        patchFile(snapshotPath, field, &value, sizeof(value));
+        assert(!tree.load(snapshotPath));
+    }
+
+    assert(source.save(snapshotPath));
+    truncateFile(snapshotPath, firstNode + 10 * sizeof(CompactNode<int>));
+    assert(!tree.load(snapshotPath));
+
+    assert(tree.size() == 1 && tree.contains(42) && tree.validate());
+}
+
+int main() {
+    testSortedKeysRoundTrip();
+    testCompactRoundTrip();
+    testCorruptHeaders();
+    testCorruptCompactNodes();
+    remove(snapshotPath.c_str());
+    std::cout << "All tests passed!" << std::endl;
+    return 0;
+}
@@ -0,0 +1,184 @@
+#ifndef WORKSTEALINGPOOL_CPP
+#define WORKSTEALINGPOOL_CPP
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+using namespace std;
+
+// Fork-join pool. Every worker owns a deque: it pushes and pops forked
+// tasks at the back, idle workers steal from the front of the others.
+// Threads outside the pool share one extra deque.
+class WorkStealingPool
+{
+    struct Task
+    {
+        function<void()> run;
+        atomic<bool> done{false};
+    };
+
+    struct Queue
+    {
+        mutex lock;
+        deque<Task *> tasks;
+    };
+
+    vector<unique_ptr<Queue>> queues;
+    vector<thread> workers;
+    atomic<bool> stopping{false};
+    atomic<int> pending{0};
+    mutex sleepLock;
+    condition_variable wakeUp;
+
+    static inline thread_local WorkStealingPool *currentPool = nullptr;
+    static inline thread_local int currentQueue = -1;
+
+    int queueOfCaller() const
+    {
+        if (currentPool == this)
+            return currentQueue;
+        return (int)queues.size() - 1;
+    }
+
+    void push(int queue, Task *task)
+    {
+        {
+            lock_guard<mutex> guard(queues[queue]->lock);
+            queues[queue]->tasks.push_back(task);
+        }
+        pending++;
+        {
+            lock_guard<mutex> guard(sleepLock);
+        }
+        wakeUp.notify_one();
+    }
+
+    Task *popBack(int queue)
+    {
+        lock_guard<mutex> guard(queues[queue]->lock);
+        if (queues[queue]->tasks.empty())
+            return nullptr;
+        Task *task = queues[queue]->tasks.back();
+        queues[queue]->tasks.pop_back();
+        pending--;
+        return task;
+    }
+
+    Task *steal(int thief)
+    {
+        int count = (int)queues.size();
+        for (int i = 1; i < count; i++)
+        {
+            Queue &victim = *queues[(thief + i) % count];
+            lock_guard<mutex> guard(victim.lock);
+            if (!victim.tasks.empty())
+            {
+                Task *task = victim.tasks.front();
+                victim.tasks.pop_front();
+                pending--;
+                return task;
+            }
+        }
+        return nullptr;
+    }
+
+    static void execute(Task *task)
+    {
+        task->run();
+        task->done.store(true, memory_order_release);
+    }
+
+    void workerLoop(int queue)
+    {
+        currentPool = this;
+        currentQueue = queue;
+        while (!stopping.load())
+        {
+            Task *task = popBack(queue);
+            if (task == nullptr)
+                task = steal(queue);
+            if (task != nullptr)
+            {
+                execute(task);
+                continue;
+            }
+            unique_lock<mutex> guard(sleepLock);
+            wakeUp.wait(guard, [this]()
+                        { return stopping.load() || pending.load() > 0; });
+        }
+    }
+
+public:
+    // threads extra workers; the thread calling invoke() always helps.
+    explicit WorkStealingPool(unsigned threads)
+    {
+        for (unsigned i = 0; i <= threads; i++)
+            queues.push_back(unique_ptr<Queue>(new Queue));
+        for (unsigned i = 0; i < threads; i++)
+            workers.push_back(thread(&WorkStealingPool::workerLoop, this, (int)i));
+    }
+
+    WorkStealingPool(const WorkStealingPool &) = delete;
+    WorkStealingPool &operator=(const WorkStealingPool &) = delete;
+
+    ~WorkStealingPool()
+    {
+        {
+            lock_guard<mutex> guard(sleepLock);
+            stopping = true;
+        }
+        wakeUp.notify_all();
+        for (thread &worker : workers)
+            worker.join();
+    }
+
+    // One pool for the whole program, one worker per extra hardware thread.
+    static WorkStealingPool &shared()
+    {
+        static WorkStealingPool pool(thread::hardware_concurrency() > 1 ? thread::hardware_concurrency() - 1 : 0);
+        return pool;
+    }
+
+    size_t threadCount() const
+    {
+        return workers.size() + 1;
+    }
+
+    // Runs left and right, possibly in parallel, and returns when both are done.
+    template <class Left, class Right>
+    void invoke(Left left, Right right)
+    {
+        int queue = queueOfCaller();
+        Task task;
+        task.run = right;
+        push(queue, &task);
+
+        left();
+
+        Task *next = popBack(queue);
+        if (next == &task)
+        {
+            right();
+            return;
+        }
+        if (next != nullptr)
+            execute(next);
+        while (!task.done.load(memory_order_acquire))
+        {
+            next = popBack(queue);
+            if (next == nullptr)
+                next = steal(queue);
+            if (next != nullptr)
+                execute(next);
+            else
+                this_thread::yield();
+        }
+    }
+};
+
+#endif